@@ -0,0 +1,316 @@
+/* conet_bench: times each pipeline stage over several sizes of the input and reports medians and
+ * throughput as JSON, so changes to the hot paths can be compared run against run. */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/graph.h"
+#include "../include/parser.h"
+#include "../include/traversal.h"
+#include "../include/analysis.h"
+#include "../include/graph_analysis.h"
+#include "../include/graph_utils.h"
+#include "../include/export_graph_json.h"
+#include "../include/config_loader.h"
+#include "../include/community.h"
+#include "../include/similarity.h"
+#include "../include/survival.h"
+#include "../include/motifs.h"
+#include "../include/projection.h"
+#include "../include/null_model.h"
+#include "../include/enrichment.h"
+#include "../include/minhash.h"
+#include "../include/post_windows.h"
+#include "../include/console_capture.h"
+#include "../include/json_writer.h"
+
+namespace fs = std::filesystem;
+
+
+const char* const USAGE =
+    "Usage: conet_bench [--data <file.csv>] [--sizes <fractions>] [--trials <n>] [--out <file.json>] [--scratch <dir>]\n"
+    "  Runs the pipeline stages one after another on the first fraction of the data rows (rounded up to\n"
+    "  the end of a patient), for each size, and writes per-stage medians and throughput to JSON.\n"
+    "  rows_per_s and edges_per_s divide by the dataset's row count and final graph edge count for\n"
+    "  every stage: size-normalised rates for comparing sizes, not edges each stage itself touched.\n"
+    "  --data     input table (default: input_data_path of config/paths.json)\n"
+    "  --sizes    comma-separated fractions of the rows, default 0.25,0.5,1\n"
+    "  --trials   runs per size, default 3\n"
+    "  --out      report file, default conet_bench.json\n"
+    "  --scratch  directory for the dataset subsets and stage outputs, default <tmp>/conet_bench\n";
+
+
+struct BenchState {
+    Graph g;
+    std::map<int, std::string> patientToDiseaseMap;
+    std::unordered_map<Node, std::unordered_set<Node>> adjacency;
+    std::map<std::pair<int, int>, std::multiset<Timepoint>> colocalizationTimeline;
+    std::map<std::tuple<int, int, int>, std::set<Timepoint>> colocalizationByIndividual;
+    std::map<std::tuple<int, int, int>, Node> firstOccurrenceByInd;
+    std::map<std::tuple<int, int, int>, std::set<Timepoint>> colocalizationTimelineByInd;
+    CommunityMap communities;
+};
+
+struct BenchStage {
+    std::string name;
+    std::function<void(BenchState&)> run;
+};
+
+struct StageTiming {
+    std::string name;
+    std::vector<double> seconds;    // one per trial
+};
+
+
+// Patient ID column of a data row
+static std::string patientOf(const std::string& line) {
+    return line.substr(0, line.find(','));
+}
+
+
+// First `fraction` of the data rows plus the header. Rows are grouped by patient and the cut moves forward to
+// the next change of patient, so no patient's colocalizations are split between sizes.
+static size_t writeSubset(const fs::path& data, double fraction, const fs::path& subset) {
+    std::ifstream in(data);
+    if (!in) throw std::runtime_error("Cannot open data file: " + data.string());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+    if (lines.empty()) throw std::runtime_error("Empty data file: " + data.string());
+
+    const size_t total = lines.size() - 1;
+    size_t rows = std::min(total, static_cast<size_t>(static_cast<double>(total) * fraction + 0.5));
+    while (rows > 0 && rows < total && patientOf(lines[rows + 1]) == patientOf(lines[rows])) ++rows;
+    std::ofstream out(subset);
+    for (size_t i = 0; i <= rows; ++i) out << lines[i] << '\n';
+    if (!out) throw std::runtime_error("Cannot write data subset: " + subset.string());
+    return rows;
+}
+
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+
+int main(int argc, char* argv[]) {
+    fs::path data_file;
+    fs::path report_path = "conet_bench.json";
+    fs::path scratch = fs::temp_directory_path() / "conet_bench";
+    std::vector<double> sizes = {0.25, 0.5, 1.0};
+    int trials = 3;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--data" && i + 1 < argc) {
+            data_file = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (arg == "--scratch" && i + 1 < argc) {
+            scratch = argv[++i];
+        } else if (arg == "--trials" && i + 1 < argc) {
+            trials = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string item; std::getline(list, item, ',');) {
+                const double fraction = std::atof(item.c_str());
+                if (fraction > 0 && fraction <= 1) sizes.push_back(fraction);
+            }
+            if (sizes.empty()) {
+                std::cerr << "No fraction in (0, 1] in --sizes\n" << USAGE;
+                return 1;
+            }
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << USAGE;
+            return 0;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n" << USAGE;
+            return 1;
+        }
+    }
+
+    // Same windows, viz schema and layout as the pipeline, so the stages do the work they do there
+    GraphJsonOptions graph_json_options;
+    CoarsenSpec coarsen_spec;
+    EnrichmentOptions enrichment_options;
+    NullModelOptions null_model_options;
+    int projection_min_shared_partners = 1, projection_min_shared_patients = 1;
+    bool compact_viz_json = false;
+    try {
+        Config cfg = loadConfig("config/paths.json");
+        if (data_file.empty()) data_file = fs::path(cfg.input_data_path);
+        auto active = std::find_if(cfg.post_window_schemes.begin(), cfg.post_window_schemes.end(),
+                                   [&](const PostWindowScheme& s) { return s.name() == cfg.active_post_windows; });
+        if (active == cfg.post_window_schemes.end())
+            throw std::runtime_error("Unknown post-FMT window scheme: " + cfg.active_post_windows);
+        setActivePostWindows(*active);
+        compact_viz_json = cfg.viz_compact_json;
+        graph_json_options.compact = cfg.viz_compact_json;
+        graph_json_options.columnar = cfg.viz_graph_schema == "columnar";
+        graph_json_options.layout = cfg.layout_enabled;
+        graph_json_options.layoutOptions.iterations = static_cast<size_t>(std::max(1, cfg.layout_iterations));
+        graph_json_options.layoutOptions.seed = static_cast<uint64_t>(cfg.layout_seed);
+        graph_json_options.layoutOptions.theta = cfg.layout_theta;
+        if (cfg.viz_coarse_arg_level == "none") coarsen_spec.arg = ARGRollup::None;
+        else if (cfg.viz_coarse_arg_level == "resistance_class") coarsen_spec.arg = ARGRollup::ResistanceClass;
+        if (cfg.viz_coarse_mge_level == "none") coarsen_spec.mge = MGERollup::None;
+        enrichment_options.permutations = static_cast<size_t>(cfg.enrichment_permutations);
+        enrichment_options.seed = static_cast<uint64_t>(cfg.enrichment_seed);
+        enrichment_options.minPatients = cfg.enrichment_min_patients;
+        null_model_options.replicates = static_cast<size_t>(cfg.null_model_replicates);
+        null_model_options.tradesPerRow = static_cast<size_t>(cfg.null_model_trades_per_row);
+        null_model_options.seed = static_cast<uint64_t>(cfg.null_model_seed);
+        null_model_options.topK = static_cast<unsigned int>(std::max(1, cfg.null_model_top_k));
+        projection_min_shared_partners = cfg.projection_min_shared_partners;
+        projection_min_shared_patients = cfg.projection_min_shared_patients;
+    } catch (const std::exception& e) {
+        std::cerr << "Config error: " << e.what() << "\n";
+        return 1;
+    }
+
+    const fs::path out = scratch / "output";
+    for (const char* dir : {"disease", "mge_group", "similarity", "shards", "projections"})
+        fs::create_directories(out / dir);
+    auto outFile = [&](const std::string& name) { return (out / name).string(); };
+    const TemporalDynamicsPaths temporal_dynamics_paths{outFile("emerge.csv"), outFile("disappear.csv"),
+                                                        outFile("transfer.csv"), outFile("persist.csv")};
+
+    // In pipeline order; every stage reads what the ones before it built
+    fs::path subset;
+    const std::vector<BenchStage> stages = {
+        {"parseData", [&](BenchState& s) { parseData(subset, s.g, s.patientToDiseaseMap, true, false); }},
+        {"addTemporalEdges", [&](BenchState& s) { addTemporalEdges(s.g); }},
+        {"buildAdjacency", [&](BenchState& s) { buildAdjacency(s.g, s.adjacency); }},
+        {"traverseAdjacency", [&](BenchState& s) { traverseAdjacency(s.g, s.adjacency, s.colocalizationTimeline); }},
+        {"traverseGraph", [&](BenchState& s) { traverseGraph(s.g, s.colocalizationByIndividual); }},
+        {"findFirstOccurrenceByInd", [&](BenchState& s) { findFirstOccurrenceByInd(s.g, s.adjacency, s.firstOccurrenceByInd); }},
+        {"traverseGraphByInd", [&](BenchState& s) {
+            traverseGraphByInd(s.g, s.adjacency, s.g.edges, s.firstOccurrenceByInd, s.colocalizationTimelineByInd);
+        }},
+        {"writeGraphStatisticsCSV", [&](BenchState& s) { writeGraphStatisticsCSV(s.g, s.adjacency, outFile("graph_statistics.csv")); }},
+        {"writeCentralityCSVs", [&](BenchState& s) { writeCentralityCSVs(s.g, outFile("centrality")); }},
+        {"writeAllProjections", [&](BenchState& s) {
+            writeAllProjections(s.g, s.patientToDiseaseMap, outFile("projections"),
+                                projection_min_shared_partners, projection_min_shared_patients);
+        }},
+        {"nullModel", [&](BenchState& s) {
+            writeNullModelCSV(runDegreePreservingNullModel(s.g, null_model_options), outFile("null_model.csv"));
+        }},
+        {"mostProminentEntities", [&](BenchState& s) { mostProminentEntities(s.g, outFile("top_args.csv"), outFile("top_mges.csv")); }},
+        {"getTopARGMGEPairsByFrequencyWODonor", [&](BenchState& s) {
+            getTopARGMGEPairsByFrequencyWODonor(s.colocalizationByIndividual, 10, s.patientToDiseaseMap, outFile("top_colocalizations.csv"));
+        }},
+        {"writeGroupedTemporalDynamicsCounts", [&](BenchState& s) {
+            writeGroupedTemporalDynamicsCounts(s.colocalizationByIndividual, s.patientToDiseaseMap, outFile("disease"), outFile("mge_group"));
+        }},
+        {"enrichment", [&](BenchState& s) {
+            writeEnrichmentCSV(runDiseaseEnrichment(s.colocalizationByIndividual, s.patientToDiseaseMap, enrichment_options),
+                               outFile("enrichment.csv"));
+        }},
+        {"exportTemporalDynamics", [&](BenchState& s) {
+            exportTemporalDynamics(s.colocalizationByIndividual, s.patientToDiseaseMap, temporal_dynamics_paths,
+                                   outFile("temporal_dynamics_disease.json"), compact_viz_json);
+        }},
+        {"writePatientSimilarity", [&](BenchState& s) { writePatientSimilarity(s.colocalizationByIndividual, s.patientToDiseaseMap, outFile("similarity")); }},
+        {"writeSimilarPatientsCSV", [&](BenchState& s) {
+            writeSimilarPatientsCSV(s.colocalizationByIndividual, s.patientToDiseaseMap, 5, outFile("similar_patients.csv"));
+        }},
+        {"survival", [&](BenchState& s) {
+            KMCurves kmCurves = computeKaplanMeierCurves(s.colocalizationByIndividual, s.patientToDiseaseMap);
+            writeKaplanMeierCSV(kmCurves, outFile("km_curves.csv"));
+            writeKaplanMeierJSON(kmCurves, outFile("km_curves.json"));
+        }},
+        {"motifs", [&](BenchState& s) {
+            writeMotifCountsCSV(countTemporalMotifs(s.g), s.patientToDiseaseMap, outFile("motifs_patient.csv"), outFile("motifs_disease.csv"));
+        }},
+        {"detectCommunities", [&](BenchState& s) { s.communities = detectCommunities(s.g, s.patientToDiseaseMap); }},
+        {"exportGraphToJsonSimple", [&](BenchState& s) {
+            exportGraphToJsonSimple(s.g, outFile("graph1.json"), s.patientToDiseaseMap, s.communities, graph_json_options);
+        }},
+        {"exportParentGraphWithShards", [&](BenchState& s) {
+            exportParentGraphWithShards(s.g, outFile("graph2.json"), outFile("shards"), s.patientToDiseaseMap, true, graph_json_options);
+        }},
+        {"exportCoarseGraphToJson", [&](BenchState& s) {
+            exportCoarseGraphToJson(coarsenGraph(s.g, coarsen_spec), outFile("graph1_groups.json"), s.patientToDiseaseMap, graph_json_options);
+        }},
+    };
+
+    JsonWriter report(report_path.string());
+    report.beginObject();
+    report.key("config").beginObject()
+          .field("data", data_file.string())
+          .field("threads", std::thread::hardware_concurrency())
+          .field("trials", trials)
+          .endObject();
+    report.key("datasets").beginArray();
+
+    for (double fraction : sizes) {
+        subset = scratch / ("data_" + std::to_string(static_cast<int>(fraction * 100 + 0.5)) + ".csv");
+        size_t rows = 0;
+        try {
+            rows = writeSubset(data_file, fraction, subset);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+
+        std::vector<StageTiming> timings;
+        for (const BenchStage& stage : stages) timings.push_back({stage.name, {}});
+        size_t nodes = 0, edges = 0;
+        for (int trial = 0; trial < trials; ++trial) {
+            BenchState state;
+            ConsoleCapture quiet;    // the stages' own reports would drown the results
+            for (size_t i = 0; i < stages.size(); ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                stages[i].run(state);
+                timings[i].seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            nodes = state.g.nodes.size();
+            edges = state.g.edges.size();
+        }
+
+        // Throughput of every stage against the same totals, data rows read and edges of the finished graph, so
+        // edges_per_s compares sizes rather than measuring the edges a stage itself visited
+        std::cout << "size " << fraction << ": " << rows << " rows, " << nodes << " nodes, " << edges << " edges\n";
+        report.beginObject()
+              .field("edges", edges)
+              .field("fraction", fraction)
+              .field("nodes", nodes)
+              .field("rows", rows);
+        report.key("stages").beginArray();
+        for (const StageTiming& timing : timings) {
+            const double mid = median(timing.seconds);
+            const auto [fastest, slowest] = std::minmax_element(timing.seconds.begin(), timing.seconds.end());
+            report.beginObject()
+                  .field("edges_per_s", mid > 0 ? static_cast<double>(edges) / mid : 0.0)
+                  .field("max_s", *slowest)
+                  .field("median_s", mid)
+                  .field("min_s", *fastest)
+                  .field("name", timing.name)
+                  .field("rows_per_s", mid > 0 ? static_cast<double>(rows) / mid : 0.0)
+                  .endObject();
+            std::cout << "  " << timing.name << ": " << mid * 1000 << " ms\n";
+        }
+        report.endArray().endObject();
+    }
+
+    report.endArray().endObject();
+    try {
+        report.close();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << report_path.string() << "\n";
+    return 0;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <cstddef>
 #include <string>
 #include <iostream>
 #include <ostream>
@@ -66,60 +68,106 @@ enum class Timepoint {
     PostFMT_730 = 730,
 };
 
+enum class TimepointCategory { Donor, PreFMT, PostFMT, Unknown };
+
+// Everything derived from a timepoint alone, resolved at compile time.
+//   ordinal: chronological position (donor first, then pre-FMT, then post-FMT days), as in Node::operator<
+// Post-FMT windows, viz category names and colours depend on the configured scheme (post_windows.h).
+struct TimepointTraits {
+    Timepoint tp;
+    const char* name;           // "donor", "pre", "post_001", ...
+    TimepointCategory category;
+    int ordinal;
+};
+
+inline constexpr TimepointTraits TIMEPOINT_TRAITS[] = {
+    {Timepoint::Donor,       "donor",    TimepointCategory::Donor,   0},
+    {Timepoint::PreFMT,      "pre",      TimepointCategory::PreFMT,  1},
+    {Timepoint::PostFMT_001, "post_001", TimepointCategory::PostFMT, 2},
+    {Timepoint::PostFMT_002, "post_002", TimepointCategory::PostFMT, 3},
+    {Timepoint::PostFMT_003, "post_003", TimepointCategory::PostFMT, 4},
+    {Timepoint::PostFMT_006, "post_006", TimepointCategory::PostFMT, 5},
+    {Timepoint::PostFMT_007, "post_007", TimepointCategory::PostFMT, 6},
+    {Timepoint::PostFMT_012, "post_012", TimepointCategory::PostFMT, 7},
+    {Timepoint::PostFMT_013, "post_013", TimepointCategory::PostFMT, 8},
+    {Timepoint::PostFMT_014, "post_014", TimepointCategory::PostFMT, 9},
+    {Timepoint::PostFMT_015, "post_015", TimepointCategory::PostFMT, 10},
+    {Timepoint::PostFMT_016, "post_016", TimepointCategory::PostFMT, 11},
+    {Timepoint::PostFMT_020, "post_020", TimepointCategory::PostFMT, 12},
+    {Timepoint::PostFMT_021, "post_021", TimepointCategory::PostFMT, 13},
+    {Timepoint::PostFMT_028, "post_028", TimepointCategory::PostFMT, 14},
+    {Timepoint::PostFMT_029, "post_029", TimepointCategory::PostFMT, 15},
+    {Timepoint::PostFMT_030, "post_030", TimepointCategory::PostFMT, 16},
+    {Timepoint::PostFMT_031, "post_031", TimepointCategory::PostFMT, 17},
+    {Timepoint::PostFMT_035, "post_035", TimepointCategory::PostFMT, 18},
+    {Timepoint::PostFMT_036, "post_036", TimepointCategory::PostFMT, 19},
+    {Timepoint::PostFMT_040, "post_040", TimepointCategory::PostFMT, 20},
+    {Timepoint::PostFMT_041, "post_041", TimepointCategory::PostFMT, 21},
+    {Timepoint::PostFMT_042, "post_042", TimepointCategory::PostFMT, 22},
+    {Timepoint::PostFMT_044, "post_044", TimepointCategory::PostFMT, 23},
+    {Timepoint::PostFMT_054, "post_054", TimepointCategory::PostFMT, 24},
+    {Timepoint::PostFMT_056, "post_056", TimepointCategory::PostFMT, 25},
+    {Timepoint::PostFMT_059, "post_059", TimepointCategory::PostFMT, 26},
+    {Timepoint::PostFMT_061, "post_061", TimepointCategory::PostFMT, 27},
+    {Timepoint::PostFMT_063, "post_063", TimepointCategory::PostFMT, 28},
+    {Timepoint::PostFMT_064, "post_064", TimepointCategory::PostFMT, 29},
+    {Timepoint::PostFMT_065, "post_065", TimepointCategory::PostFMT, 30},
+    {Timepoint::PostFMT_068, "post_068", TimepointCategory::PostFMT, 31},
+    {Timepoint::PostFMT_081, "post_081", TimepointCategory::PostFMT, 32},
+    {Timepoint::PostFMT_084, "post_084", TimepointCategory::PostFMT, 33},
+    {Timepoint::PostFMT_090, "post_090", TimepointCategory::PostFMT, 34},
+    {Timepoint::PostFMT_094, "post_094", TimepointCategory::PostFMT, 35},
+    {Timepoint::PostFMT_095, "post_095", TimepointCategory::PostFMT, 36},
+    {Timepoint::PostFMT_097, "post_097", TimepointCategory::PostFMT, 37},
+    {Timepoint::PostFMT_098, "post_098", TimepointCategory::PostFMT, 38},
+    {Timepoint::PostFMT_111, "post_111", TimepointCategory::PostFMT, 39},
+    {Timepoint::PostFMT_112, "post_112", TimepointCategory::PostFMT, 40},
+    {Timepoint::PostFMT_120, "post_120", TimepointCategory::PostFMT, 41},
+    {Timepoint::PostFMT_135, "post_135", TimepointCategory::PostFMT, 42},
+    {Timepoint::PostFMT_140, "post_140", TimepointCategory::PostFMT, 43},
+    {Timepoint::PostFMT_150, "post_150", TimepointCategory::PostFMT, 44},
+    {Timepoint::PostFMT_179, "post_179", TimepointCategory::PostFMT, 45},
+    {Timepoint::PostFMT_180, "post_180", TimepointCategory::PostFMT, 46},
+    {Timepoint::PostFMT_195, "post_195", TimepointCategory::PostFMT, 47},
+    {Timepoint::PostFMT_365, "post_365", TimepointCategory::PostFMT, 48},
+    {Timepoint::PostFMT_384, "post_384", TimepointCategory::PostFMT, 49},
+    {Timepoint::PostFMT_408, "post_408", TimepointCategory::PostFMT, 50},
+    {Timepoint::PostFMT_730, "post_730", TimepointCategory::PostFMT, 51},
+};
+
+inline constexpr TimepointTraits UNKNOWN_TIMEPOINT_TRAITS =
+    {Timepoint::PreFMT, "unknown", TimepointCategory::Unknown, -1};
+
+inline constexpr std::size_t TIMEPOINT_COUNT = sizeof(TIMEPOINT_TRAITS) / sizeof(TIMEPOINT_TRAITS[0]);
+inline constexpr int MAX_TIMEPOINT_VALUE = static_cast<int>(Timepoint::Donor);
+
+namespace timepoint_detail {
+// Enum value -> row of TIMEPOINT_TRAITS (TIMEPOINT_COUNT = unknown)
+constexpr std::array<unsigned char, MAX_TIMEPOINT_VALUE + 1> buildIndex() {
+    std::array<unsigned char, MAX_TIMEPOINT_VALUE + 1> index{};
+    for (auto& row : index) row = static_cast<unsigned char>(TIMEPOINT_COUNT);
+    for (std::size_t i = 0; i < TIMEPOINT_COUNT; ++i)
+        index[static_cast<std::size_t>(TIMEPOINT_TRAITS[i].tp)] = static_cast<unsigned char>(i);
+    return index;
+}
+inline constexpr auto TIMEPOINT_INDEX = buildIndex();
+} // namespace timepoint_detail
+
+constexpr const TimepointTraits& traitsOf(Timepoint tp) {
+    const int v = static_cast<int>(tp);
+    if (v < 0 || v > MAX_TIMEPOINT_VALUE) return UNKNOWN_TIMEPOINT_TRAITS;
+    const std::size_t row = timepoint_detail::TIMEPOINT_INDEX[v];
+    return row < TIMEPOINT_COUNT ? TIMEPOINT_TRAITS[row] : UNKNOWN_TIMEPOINT_TRAITS;
+}
+
+constexpr bool isDonor(Timepoint tp)   { return traitsOf(tp).category == TimepointCategory::Donor; }
+constexpr bool isPreFMT(Timepoint tp)  { return traitsOf(tp).category == TimepointCategory::PreFMT; }
+constexpr bool isPostFMT(Timepoint tp) { return traitsOf(tp).category == TimepointCategory::PostFMT; }
+constexpr int ordinalOf(Timepoint tp)  { return traitsOf(tp).ordinal; }
+
+static_assert(ordinalOf(Timepoint::Donor) < ordinalOf(Timepoint::PreFMT) &&
+              ordinalOf(Timepoint::PreFMT) < ordinalOf(Timepoint::PostFMT_001), "chronological ordinals");
+
 inline std::string toString(Timepoint tp) {
-    switch (tp) {
-        case Timepoint::Donor: return "donor";
-        case Timepoint::PreFMT: return "pre";
-        case Timepoint::PostFMT_001: return "post_001";
-        case Timepoint::PostFMT_002: return "post_002";
-        case Timepoint::PostFMT_003: return "post_003";
-        case Timepoint::PostFMT_006: return "post_006";
-        case Timepoint::PostFMT_007: return "post_007";
-        case Timepoint::PostFMT_012: return "post_012";
-        case Timepoint::PostFMT_013: return "post_013";
-        case Timepoint::PostFMT_014: return "post_014";
-        case Timepoint::PostFMT_015: return "post_015";
-        case Timepoint::PostFMT_016: return "post_016";
-        case Timepoint::PostFMT_020: return "post_020";
-        case Timepoint::PostFMT_021: return "post_021";
-        case Timepoint::PostFMT_028: return "post_028";
-        case Timepoint::PostFMT_029: return "post_029";
-        case Timepoint::PostFMT_030: return "post_030";
-        case Timepoint::PostFMT_031: return "post_031";
-        case Timepoint::PostFMT_035: return "post_035";
-        case Timepoint::PostFMT_036: return "post_036";
-        case Timepoint::PostFMT_040: return "post_040";
-        case Timepoint::PostFMT_041: return "post_041";
-        case Timepoint::PostFMT_042: return "post_042";
-        case Timepoint::PostFMT_044: return "post_044";
-        case Timepoint::PostFMT_054: return "post_054";
-        case Timepoint::PostFMT_056: return "post_056";
-        case Timepoint::PostFMT_059: return "post_059";
-        case Timepoint::PostFMT_061: return "post_061";
-        case Timepoint::PostFMT_063: return "post_063";
-        case Timepoint::PostFMT_064: return "post_064";
-        case Timepoint::PostFMT_065: return "post_065";
-        case Timepoint::PostFMT_068: return "post_068";
-        case Timepoint::PostFMT_081: return "post_081";
-        case Timepoint::PostFMT_084: return "post_084";
-        case Timepoint::PostFMT_090: return "post_090";
-        case Timepoint::PostFMT_094: return "post_094";
-        case Timepoint::PostFMT_095: return "post_095";
-        case Timepoint::PostFMT_097: return "post_097";
-        case Timepoint::PostFMT_098: return "post_098";
-        case Timepoint::PostFMT_111: return "post_111";
-        case Timepoint::PostFMT_112: return "post_112";
-        case Timepoint::PostFMT_120: return "post_120";
-        case Timepoint::PostFMT_135: return "post_135";
-        case Timepoint::PostFMT_140: return "post_140";
-        case Timepoint::PostFMT_150: return "post_150";
-        case Timepoint::PostFMT_179: return "post_179";
-        case Timepoint::PostFMT_180: return "post_180";
-        case Timepoint::PostFMT_195: return "post_195";
-        case Timepoint::PostFMT_365: return "post_365";
-        case Timepoint::PostFMT_384: return "post_384";
-        case Timepoint::PostFMT_408: return "post_408";
-        case Timepoint::PostFMT_730: return "post_730";
-        default: return "unknown";
-    }
+    return traitsOf(tp).name;
 }
\ No newline at end of file
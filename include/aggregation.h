@@ -0,0 +1,71 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Timepoint.h"
+
+// Group-by dimensions of a (patient, ARG, MGE) entry. Every dimension is a dense code 0..cardinality-1;
+// ARG and MGE codes follow ascending IDs, dictionary dimensions follow ascending names.
+enum class GroupDimension {
+    Disease,
+    MGEGroup,
+    ARGGroup,
+    ResistanceClass,
+    ARG,
+    MGE,
+    Pattern,        // 3-bit donor/pre/post pattern (TemporalPattern)
+    Donor,          // 0/1
+    PreFMT,         // 0/1
+    PostFMT,        // 0/1
+    PostBin         // latest window of the active post-FMT scheme, 0 = none
+};
+
+// Counts per combination of the table's dimensions, sorted by key (lexicographic in dimension order)
+struct CountTable {
+    std::vector<GroupDimension> dims;
+    std::vector<uint64_t> radix;                          // cardinality per dimension
+    std::vector<std::pair<uint64_t, long long>> counts;   // packed mixed-radix key -> count
+
+    std::vector<int> decode(uint64_t key) const;
+    void decodeInto(uint64_t key, std::vector<int>& codes) const;   // reuses the caller's buffer
+};
+
+class GroupByEngine {
+public:
+    // Encodes every entry's dimensions once; string lookups happen per distinct ARG/MGE/patient only
+    GroupByEngine(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                  const std::map<int, std::string>& patientToDiseaseMap, size_t threads = 0);
+
+    // Registers a table; returns its index for table()
+    size_t addTable(std::vector<GroupDimension> dims);
+
+    // Fills all registered tables in one parallel pass over the entries
+    void run();
+
+    const CountTable& table(size_t index) const { return tables_[index]; }
+
+    // Display value of a code: disease / group / class name, ARG or MGE ID, or the numeric value
+    std::string label(GroupDimension dim, int code) const;
+    int cardinality(GroupDimension dim) const;
+
+    // ARG or MGE ID behind an ARG / MGE code
+    int entityId(GroupDimension dim, int code) const;
+
+private:
+    static constexpr size_t DIMENSIONS = static_cast<size_t>(GroupDimension::PostBin) + 1;
+
+    size_t threads_;
+    size_t entries_ = 0;
+    std::vector<std::vector<int>> columns_;                  // per dimension, code per entry
+    std::vector<std::vector<std::string>> dictionaries_;     // per dimension, code -> label (dictionary dims)
+    std::vector<int> argIds_, mgeIds_;                       // code -> ID
+    std::vector<CountTable> tables_;
+};
+
+#endif // AGGREGATION_H
@@ -1,5 +1,5 @@
-#ifndef QUERY_ENGINE_H
-#define QUERY_ENGINE_H
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
 #include <map>
 #include <set>
 #include <tuple>
@@ -8,10 +8,7 @@
 #include <string>
 #include "graph.h"
 #include "Timepoint.h"
-
-bool isPostFMT(const Timepoint& tp);
-bool isPreFMT(const Timepoint& tp);
-bool isDonor(const Timepoint& tp);
+#include "topk.h"
 
 void getPatientwiseColocalizationsByCriteria(
     const Graph& graph,
@@ -27,6 +24,8 @@ void getPatientwiseColocalizationsByCriteria(
 void getTopARGMGEPairsByFrequency(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizations, int topN = -1);
 void getTopARGMGEPairsByFrequencyWODonor(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizations, int topN = -1, 
     const std::map<int, std::string>& patientToDiseaseMap = {}, const std::string& top_colocalizations_output = {});
+void getTopARGMGEPairsByGroup(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizations, int topN,
+    const std::map<int, std::string>& patientToDiseaseMap, const std::string& outputCSV, TopKMode mode = TopKMode::Exact);
 void getConnectedMGE(const Graph& graph, const std::set<Edge>& edges, int mgeId, const std::string& mgeName);
 
 void getColocalizationsByCriteria(
@@ -42,19 +41,33 @@ void getTopARGMGEPairsByUniquePatients(
     const std::string& label = "All Patients"
 );
 
+// Replaces characters that are not allowed in file names (/ \ : * ? " < > |) with '_'
+std::string sanitizeFileName(const std::string& name);
+
+// Count tables are written as <outputDir>/<disease>.csv and <outputDir>/<MGE group>.csv
 void writeTemporalDynamicsCountsForDisease(
     const std::string& disease,
     std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
-    const std::map<int, std::string>& patientToDiseaseMap
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& outputDir
 );
 
 void writeAllDiseasesTemporalDynamicsCounts(
     std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
-    const std::map<int, std::string>& patientToDiseaseMap
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& outputDir
 );
 
 void writeTemporalDynamicsCountsForMGEGroup(
-    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const std::string& outputDir
+);
+
+void writeGroupedTemporalDynamicsCounts(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& diseaseOutputDir,
+    const std::string& mgeGroupOutputDir
 );
 
 void writeColocalizationsToCSV(
@@ -64,8 +77,25 @@ void writeColocalizationsToCSV(
     bool append = false
 );
 
-void exportColocalizations(const Graph& g,
-    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual
+// Emerge / disappear / transfer / persist CSVs written by the temporal dynamics exports
+struct TemporalDynamicsPaths {
+    std::string emerge;
+    std::string disappear;
+    std::string transfer;
+    std::string persist;
+};
+
+void exportColocalizations(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const TemporalDynamicsPaths& paths
+);
+
+void exportTemporalDynamics(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const TemporalDynamicsPaths& paths,
+    const std::string& diseaseJsonPath,
+    bool compactJson = false
 );
 
 
@@ -81,7 +111,7 @@ void analyzeColocalizations(const Graph& g,
 void analyzeColocalizationsCollectively(const Graph& g, 
                                           const std::unordered_map<Node, std::unordered_set<Node>>& adjacency);
 
-void mostProminentEntities(const Graph& g);
+void mostProminentEntities(const Graph& g, const std::string& topARGCSV, const std::string& topMGECSV);
 
 void writeTopEntitiesToCSV(const std::string& filename, const std::vector<std::pair<int, int>>& entities, bool isARG);
 
@@ -0,0 +1,29 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <cstdint>
+
+// Bit tricks on 64-bit masks: compiler builtins where available, portable loops elsewhere (MSVC)
+
+inline int popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1) ++count;
+    return count;
+#endif
+}
+
+// Index of the lowest set bit; x must be non-zero
+inline int countTrailingZeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; ++n; }
+    return n;
+#endif
+}
+
+#endif // BITS_H
@@ -0,0 +1,39 @@
+#ifndef COMMUNITY_H
+#define COMMUNITY_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "graph.h"
+#include "graph_analysis.h"
+
+// Community per entity: (entity ID, isARG) -> community index
+using CommunityMap = std::map<std::pair<int, bool>, int>;
+
+struct CommunityOptions {
+    std::string disease;            // restrict via filterGraphByDisease when non-empty
+    std::string timepointCategory;  // restrict via filterGraphByTimepoint ("donor", "pre", "post") when non-empty
+    int maxLevels = 10;
+    int maxSweeps = 32;
+    double minGain = 1e-7;          // stop a level once a sweep improves modularity by less than this
+    size_t threads = 0;             // 0 = hardware concurrency
+};
+
+struct CommunityResult {
+    std::vector<int> community;     // per CompactGraph vertex, labels 0..communityCount-1
+    int communityCount = 0;
+    double modularity = 0.0;
+    int levels = 0;
+};
+
+// Louvain with a parallel local-moving phase on any weighted CompactGraph (bipartite or projection)
+CommunityResult louvainCommunities(const CompactGraph& cg, const CommunityOptions& options = {});
+
+double computeModularity(const CompactGraph& cg, const std::vector<int>& community);
+
+// Filters the colocalization graph as requested, runs Louvain and maps the result back to entities
+CommunityMap detectCommunities(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                               const CommunityOptions& options = {});
+
+#endif // COMMUNITY_H
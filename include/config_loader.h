@@ -4,7 +4,9 @@
 #define CONFIG_LOADER_H
 
 #include <string>
+#include <vector>
 #include "../external/json.hpp"
+#include "post_windows.h"
 
 struct Config {
     std::string input_data_path;
@@ -23,10 +25,62 @@ struct Config {
     std::string output_top_arg;
     std::string output_top_mge;
     std::string output_top_colocalizations;
+    std::string output_top_colocalizations_by_group;
+    std::string output_centrality_prefix;
+
+    std::string output_motifs_patient;
+    std::string output_motifs_disease;
+
+    std::string output_projections;
+    int projection_min_shared_partners = 1;
+    int projection_min_shared_patients = 1;
+
+    std::string output_similarity;
+    std::string output_similar_patients;
+    std::string output_survival;
+    std::string output_post_windows;
+
+    std::string output_enrichment;
+    int enrichment_permutations = 10000;
+    int enrichment_seed = 42;
+    int enrichment_min_patients = 2;
+
+    std::string output_null_model;
+    int null_model_replicates = 500;
+    int null_model_trades_per_row = 10;
+    int null_model_seed = 42;
+    int null_model_top_k = 10;
+
+    // post-FMT binning schemes; active_post_windows names the one used by the reports
+    std::vector<PostWindowScheme> post_window_schemes;
+    std::string active_post_windows;
 
     std::string viz_interaction;
     std::string viz_parent;
+    std::string viz_parent_shards;
+    // graph1 rolled up by hierarchy level: ARGs "none"/"group"/"resistance_class", MGEs "none"/"group"
+    std::string viz_coarse;
+    std::string viz_coarse_arg_level = "group";
+    std::string viz_coarse_mge_level = "group";
     std::string viz_temporal_dynamics;
+    std::string viz_survival;
+    // viz JSON without pretty-printing whitespace
+    bool viz_compact_json = false;
+    // "records" (one object per node/link) or "columnar" (see export_graph_json.h) for graph1/graph2
+    std::string viz_graph_schema = "records";
+
+    // precomputed force-directed positions for graph1/graph2 (Barnes–Hut)
+    bool layout_enabled = true;
+    int layout_iterations = 300;
+    int layout_seed = 42;
+    double layout_theta = 0.9;
+
+    // content-addressed stage cache; stages with unchanged inputs are skipped
+    std::string cache_dir;
+    bool cache_enabled = true;
+
+    // workers running independent pipeline stages concurrently, 0 = hardware threads
+    int scheduler_threads = 0;
 };
 
 
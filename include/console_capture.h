@@ -0,0 +1,35 @@
+#ifndef CONSOLE_CAPTURE_H
+#define CONSOLE_CAPTURE_H
+
+#include <cstddef>
+#include <string>
+
+/* Collects what the current thread writes to std::cout while in scope; other threads are unaffected,
+ * so stages running side by side keep their console output apart. Captures nest: text reaches every
+ * active capture of the thread, and the terminal only if all of them pass it through.
+ */
+class ConsoleCapture {
+public:
+    explicit ConsoleCapture(bool passThrough = false);
+    ~ConsoleCapture();
+
+    ConsoleCapture(const ConsoleCapture&) = delete;
+    ConsoleCapture& operator=(const ConsoleCapture&) = delete;
+
+    const std::string& text() const { return text_; }
+
+    // Puts the router in front of std::cout; the first capture does this, call it before starting threads
+    static void install();
+
+private:
+    friend class ConsoleRouter;
+
+    // Appends to the thread's captures; returns whether the text should also reach the terminal
+    static bool route(const char* s, size_t n);
+
+    bool passThrough_;
+    std::string text_;
+    ConsoleCapture* outer_;
+};
+
+#endif // CONSOLE_CAPTURE_H
@@ -0,0 +1,107 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+/* Streaming CSV output: rows are formatted straight into a large buffer and written in blocks,
+ * so callers never materialize their tables as vectors of strings.
+ *
+ *   CsvWriter csv(filename);
+ *   csv.header({"ARG", "MGE", "Patients"});
+ *   for (...) csv.row(getARGName(arg), getMGEName(mge), patients);
+ *
+ * Integers go through std::to_chars, doubles are fixed with 6 decimals (as std::to_string).
+ * Fields containing a comma, quote or line break are quoted with inner quotes doubled.
+ * With backgroundFlush a writer thread does the file I/O while the next block is formatted.
+ */
+struct CsvWriterOptions {
+    size_t bufferSize = 1 << 20;
+    bool backgroundFlush = false;
+};
+
+class CsvWriter {
+public:
+    // Throws std::runtime_error when the file cannot be opened
+    CsvWriter(const std::string& filename, bool append = false, CsvWriterOptions options = CsvWriterOptions());
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    // Skipped when appending, like the rows of an existing file that already carry one
+    CsvWriter& header(std::initializer_list<std::string_view> names);
+    template <typename Container>
+    CsvWriter& headerFrom(const Container& names) {
+        if (!append_) {
+            for (const auto& name : names) field(std::string_view(name));
+            endRow();
+        }
+        return *this;
+    }
+
+    CsvWriter& field(std::string_view value);
+    CsvWriter& field(const std::string& value) { return field(std::string_view(value)); }
+    CsvWriter& field(const char* value) { return field(std::string_view(value)); }
+    CsvWriter& field(double value);
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>>
+    CsvWriter& field(T value) {
+        separate();
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, result.ptr);
+        return *this;
+    }
+    // Empty cell, e.g. an open-ended range
+    CsvWriter& empty() { separate(); return *this; }
+
+    CsvWriter& endRow();
+
+    template <typename... Fields>
+    CsvWriter& row(const Fields&... fields) {
+        (field(fields), ...);
+        return endRow();
+    }
+
+    // Writes what is buffered and closes the file; throws std::runtime_error on write errors.
+    // The destructor closes too, but has to swallow those errors.
+    void close();
+
+    size_t rowsWritten() const { return rows_; }
+
+private:
+    void separate() {
+        if (rowOpen_) buffer_ += ',';
+        rowOpen_ = true;
+    }
+    void flushBuffer();
+    void writeBlock(const std::string& block);
+    void writerLoop();
+
+    std::string filename_;
+    std::FILE* file_ = nullptr;
+    bool append_;
+    CsvWriterOptions options_;
+    std::string buffer_;
+    bool rowOpen_ = false;
+    size_t rows_ = 0;
+
+    // Background flush: the writer thread owns `pending_` while `pendingFull_` is set
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::string pending_;
+    bool pendingFull_ = false;
+    bool stopping_ = false;
+    std::exception_ptr writeError_;
+};
+
+#endif // CSV_WRITER_H
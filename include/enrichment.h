@@ -0,0 +1,39 @@
+#ifndef ENRICHMENT_H
+#define ENRICHMENT_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "Timepoint.h"
+
+struct EnrichmentOptions {
+    size_t permutations = 10000;
+    uint64_t seed = 42;
+    int minPatients = 2;        // pairs carried by fewer (non-donor) patients are not tested
+    size_t threads = 0;
+};
+
+// One (ARG–MGE pair, disease) test
+struct EnrichmentResult {
+    int argID;
+    int mgeID;
+    std::string disease;
+    int carriers;           // patients carrying the pair outside the donor sample
+    int observed;           // carriers with this disease
+    double expected;        // mean of observed under label permutation
+    double pValue;          // one-sided: (1 + #{permutations with count >= observed}) / (1 + permutations)
+    double qValue;          // Benjamini–Hochberg over all tests
+};
+
+// Disease labels are permuted across patients (group sizes kept); every permutation draws from its
+// own seeded stream, so results do not depend on the thread count. Sorted by q-value, then p-value.
+std::vector<EnrichmentResult> runDiseaseEnrichment(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                                   const std::map<int, std::string>& patientToDiseaseMap,
+                                                   const EnrichmentOptions& options = EnrichmentOptions());
+
+void writeEnrichmentCSV(const std::vector<EnrichmentResult>& results, const std::string& filename);
+
+#endif // ENRICHMENT_H
@@ -2,13 +2,81 @@
 #include <string>
 #include <map>
 #include "graph.h"
+#include "community.h"
+#include "graph_utils.h"
+#include "json_writer.h"
+#include "layout.h"
 
-bool exportGraphToJsonSimple(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap);
+struct JsonGraphCounts {
+    size_t nodes = 0;
+    size_t links = 0;
+};
 
-bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap, bool showLabels = true);
+/* Columnar schema for graph1.json/graph2.json, expanded back into records by graph.js:
+ *
+ *   {"format": GRAPH_JSON_COLUMNAR_FORMAT,
+ *    "links":  {"color": [0, 0, 1, ...], "source": [12, 40, ...], "target": [...], ...},
+ *    "nodes":  {"id": ["N_1234_MGE_14", ...], "timepoint": [...], ...},
+ *    "timepointCategories": [...],
+ *    "tables": {"color": ["#696969", ...], "disease": [...], ...}}
+ *
+ * Every field of the record schema becomes one array with a value per row, except:
+ *   - color, shape, mgeGroup, timepointCategory, style and type hold indices into the table of that name
+ *   - source/target hold node row indices (ids for endpoints stored in another shard); isARG/isColo hold 0/1
+ *   - link diseases hold arrays of indices into tables.disease
+ *   - parent-node diseaseCounts hold flat [disease index, count, ...] arrays (diseases are their keys)
+ *   - community is -1 for entities without one and is absent when detection was not run
+ *   - x/y (precomputed layout) are absent when the layout is disabled
+ *
+ * Both schemes (and the shard manifest) carry "timepointCategories": [{"color", "label", "name"}, ...],
+ * the categories of the active post-FMT window scheme in timeline order, from which graph.js builds
+ * its stage filter.
+ */
+inline constexpr const char GRAPH_JSON_COLUMNAR_FORMAT[] = "conet-columnar-1";
 
+struct GraphJsonOptions {
+    bool compact = false;    // drop the pretty-printing whitespace of the record schema
+    bool columnar = false;   // columnar schema above, always written compact
+    bool layout = false;     // precomputed node positions as x/y, so graph.js can skip its simulation
+    LayoutOptions layoutOptions;
+};
+
+// Streams the interaction view document ({"links", "nodes", "timepointCategories"}) as written to graph1.json
+JsonGraphCounts writeGraphJsonSimple(JsonWriter& out, const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                                     const CommunityMap& communities = {});
+
+bool exportGraphToJsonSimple(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             const CommunityMap& communities = {}, const GraphJsonOptions& options = {});
+
+/* Interaction view of a coarsened graph (coarsenGraph): same document and schema as graph1.json,
+ * with group nodes named "G_<group>_ARG_<tp>"/"G_<group>_MGE_<tp>" and labelled by the group name.
+ * Sides that were not rolled up keep their entity names. */
+bool exportCoarseGraphToJson(const CoarseGraph& coarse, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             const GraphJsonOptions& options = {});
+
+bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             bool showLabels = true, const GraphJsonOptions& options = {});
+
+/* graph2.json pre-split for the viz filters, written in parallel from one pass over the graph:
+ *   all/<category>.json                one shard per timepoint category
+ *   by_disease/<disease>/<category>.json  nodes of patients with that disease
+ *   by_mge_group/<group>.json           one shard per MGE group
+ * plus manifest.json mapping {"all": {category: file}, "diseases": {disease: {category: file}},
+ * "mgeGroups": {group: file}} and listing "timepointCategories". A link is stored with its source node (in disease shards only when
+ * its target shares the disease), so the union of the shards for a filter holds all links among them.
+ */
+bool exportParentGraphShards(const Graph& g, const std::string& shardDir, const std::map<int, std::string>& patientToDiseaseMap,
+                             bool showLabels = true, const GraphJsonOptions& options = {});
+
+// graph2.json and its shards from one build (and one layout) of the view; false if either could not be written
+bool exportParentGraphWithShards(const Graph& g, const std::string& outPathStr, const std::string& shardDir,
+                                 const std::map<int, std::string>& patientToDiseaseMap, bool showLabels = true,
+                                 const GraphJsonOptions& options = {});
+
+// compact drops the pretty-printing whitespace; the document structure is the same
 void exportColocalizationsToJSONByDisease(
     const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
     const std::map<int, std::string>& patientToDiseaseMap,
-    const std::string& jsonOutputPath  // path to the final JSON file
+    const std::string& jsonOutputPath,  // path to the final JSON file
+    bool compact = false
 );
@@ -0,0 +1,40 @@
+#ifndef GRAPH_ANALYSIS_H
+#define GRAPH_ANALYSIS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "graph.h"
+
+// Compact (CSR) undirected ARG–MGE colocalization network with timepoints collapsed.
+// Vertex v is entity (entityId[v], isARG[v]); edge weight = number of distinct patients carrying the pair
+// at any of the included timepoints.
+struct CompactGraph {
+    std::vector<int> entityId;
+    std::vector<bool> isARG;
+    std::vector<size_t> offsets;      // size = vertices + 1
+    std::vector<int> neighbors;
+    std::vector<double> weights;
+
+    size_t vertexCount() const { return entityId.size(); }
+    size_t edgeCount() const { return neighbors.size() / 2; }
+};
+
+struct CentralityScores {
+    std::vector<int> degree;
+    std::vector<double> weightedDegree;
+    std::vector<double> pageRank;
+    std::vector<double> betweenness;   // sampled estimate, scaled to the full vertex count
+};
+
+// Build the CSR network from colocalization edges; includeTimepoint restricts it to one layer
+CompactGraph buildColocalizationCSR(const Graph& g, const std::function<bool(Timepoint)>& includeTimepoint = nullptr);
+
+std::vector<double> computePageRank(const CompactGraph& cg, double damping = 0.85, int maxIterations = 100, double tolerance = 1e-10);
+std::vector<double> computeSampledBetweenness(const CompactGraph& cg, size_t samples = 256, unsigned int seed = 42);
+CentralityScores computeCentrality(const CompactGraph& cg, size_t betweennessSamples = 256);
+
+// Writes <prefix>_<layer>.csv for the aggregated network and each timepoint category layer
+void writeCentralityCSVs(const Graph& g, const std::string& outputPrefix, size_t betweennessSamples = 256);
+
+#endif // GRAPH_ANALYSIS_H
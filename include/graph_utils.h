@@ -5,6 +5,7 @@
 #include <string>
 #include <unordered_set>
 #include <map>
+#include <vector>
 
 Graph filterGraphByARGName(const Graph& g, const std::string& argName);
 Graph filterGraphByMGEName(const Graph& g, const std::string& mgeName);
@@ -13,4 +14,30 @@ Graph filterGraphByTimepoint(const Graph& g, const std::string& timepointCategor
 Graph filterGraphByARGAndMGENames(const Graph& g, const std::string& argName, const std::string& mgeName);
 Graph filterGraphByDisease(const Graph& g, const std::string& disease, const std::map<int, std::string>& patientToDiseaseMap);
 
+// ------------------ Coarsening ------------------
+
+enum class ARGRollup { None, Group, ResistanceClass };   // argGroupMap, argResistanceMap
+enum class MGERollup { None, Group };                    // mgeGroupMap
+
+struct CoarsenSpec {
+    ARGRollup arg = ARGRollup::Group;
+    MGERollup mge = MGERollup::Group;
+};
+
+/* Graph over hierarchy groups: every (group, timepoint) becomes one node, so the temporal
+ * edges between timepoints survive the contraction. Rolled-up node ids index argLabels /
+ * mgeLabels (in label order); a side left at None keeps its entity ids and empty tables. */
+struct CoarseGraph {
+    Graph graph;
+    CoarsenSpec spec;
+    std::vector<std::string> argLabels;
+    std::vector<std::string> mgeLabels;
+    std::vector<size_t> argMembers;   // distinct entities folded into each group
+    std::vector<size_t> mgeMembers;
+};
+
+// Contracts g by spec; edges landing on the same coarse pair merge with their patient sets
+// united and weights summed. Edges are contracted in parallel chunks and merged afterwards.
+CoarseGraph coarsenGraph(const Graph& g, const CoarsenSpec& spec, size_t threads = 0);
+
 #endif // GRAPH_UTILS_H
\ No newline at end of file
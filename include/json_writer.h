@@ -0,0 +1,89 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/* Streaming (SAX-style) JSON output: documents are emitted token by token into a block buffer,
+ * so exporters never build a json DOM of the whole graph.
+ *
+ *   JsonWriter out(filename);
+ *   out.beginObject().key("nodes").beginArray();
+ *   for (...) out.beginObject().field("id", name).field("timepoint", tp).endObject();
+ *   out.endArray().endObject();
+ *   out.close();
+ *
+ * The pretty form (indent >= 0) is byte-identical to nlohmann's dump(indent): same separators,
+ * escaping and number formatting. nlohmann orders object keys alphabetically, so callers write
+ * keys in ascending byte order to keep the files unchanged (checked by assert in debug builds).
+ * A negative indent gives the compact form of dump().
+ */
+class JsonWriter {
+public:
+    // File target, ended with a newline on close(); throws std::runtime_error when it cannot be opened
+    explicit JsonWriter(const std::string& filename, int indent = 2, size_t bufferSize = 1 << 20);
+    // In-memory target, e.g. a response body; the text is appended to *target as it is written
+    explicit JsonWriter(std::string* target, int indent = -1);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(double number);
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>>
+    JsonWriter& value(T number) {
+        beginValue();
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        out_->append(digits, result.ptr);
+        return endValue();
+    }
+    JsonWriter& null();
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v) { key(name); return value(v); }
+
+    // Flushes the buffer and closes the file; throws std::runtime_error on write errors
+    void close();
+
+private:
+    struct Scope {
+        explicit Scope(bool isArray) : array(isArray) {}
+        bool array;
+        bool empty = true;
+#ifndef NDEBUG
+        std::string lastKey;
+#endif
+    };
+
+    void beginValue();
+    JsonWriter& endValue();
+    void newline();
+    void writeString(std::string_view text);
+    void flushBuffer();
+
+    std::string filename_;
+    std::FILE* file_ = nullptr;
+    std::string buffer_;
+    std::string* out_;
+    size_t bufferSize_ = 0;
+    int indent_;
+    std::vector<Scope> scopes_;
+    bool afterKey_ = false;
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,41 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Force-directed layout precomputed for the viz, so the browser can draw without simulating.
+ *
+ * Follows the d3-force simulation graph.js runs (link springs, many-body charge, centering and
+ * x/y gravity, velocity Verlet with the same alpha schedule), with the many-body term computed by
+ * Barnes–Hut over a quadtree and split across threads. Every node only reads the tree and writes
+ * its own velocity, so the result depends on the seed alone, not on the thread count.
+ */
+struct LayoutOptions {
+    size_t iterations = 300;     // d3's default schedule: alpha decays from 1 to 0.001 in 300 ticks
+    uint64_t seed = 42;          // initial positions
+    double theta = 0.9;          // Barnes–Hut opening criterion; 0 is exact
+    double charge = -40.0;       // per-node many-body strength (negative repels)
+    double centerX = 500.0;      // canvas center graph.js pulls towards
+    double centerY = 350.0;
+    double gravity = 0.05;       // strength of the x/y pull to the center
+    size_t threads = 0;          // 0 = hardware threads
+};
+
+struct LayoutEdge {
+    size_t source;
+    size_t target;
+    double distance;             // rest length of the link spring
+};
+
+struct LayoutPoint {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// Positions for nodes [0, nodeCount); throws std::invalid_argument for edges out of range
+std::vector<LayoutPoint> forceDirectedLayout(size_t nodeCount, const std::vector<LayoutEdge>& edges,
+                                             const LayoutOptions& options = LayoutOptions());
+
+#endif // LAYOUT_H
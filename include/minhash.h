@@ -0,0 +1,47 @@
+#ifndef MINHASH_H
+#define MINHASH_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Timepoint.h"
+
+struct MinHashOptions {
+    size_t numHashes = 128;
+    size_t bands = 32;              // numHashes / bands rows per band
+    uint64_t seed = 42;
+    size_t threads = 0;
+};
+
+// MinHash signatures plus an LSH banding index over a family of sets (e.g. the patients' pair sets)
+struct MinHashIndex {
+    std::vector<int> ids;                                   // set ID per row
+    std::unordered_map<int, size_t> rowOf;
+    size_t numHashes = 0;
+    size_t rowsPerBand = 0;
+    std::vector<uint64_t> signatures;                       // ids.size() * numHashes
+    std::vector<std::unordered_map<uint64_t, std::vector<size_t>>> buckets;   // per band: band hash -> rows
+
+    const uint64_t* signature(size_t row) const { return signatures.data() + row * numHashes; }
+    double estimateJaccard(size_t a, size_t b) const;
+
+    // Top-k most similar sets to setID among LSH candidates, by estimated Jaccard (desc), ties by ID
+    std::vector<std::pair<int, double>> query(int setID, size_t k) const;
+};
+
+// Elements are arbitrary 64-bit keys; sets with no elements get no row
+MinHashIndex buildMinHashIndex(const std::map<int, std::vector<uint64_t>>& sets, const MinHashOptions& options = {});
+
+// Patient -> encoded (ARG, MGE) pairs
+std::map<int, std::vector<uint64_t>> patientPairSets(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual);
+
+// For every patient, its k nearest patients from the LSH index
+void writeSimilarPatientsCSV(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                             const std::map<int, std::string>& patientToDiseaseMap, size_t k, const std::string& filename);
+
+#endif // MINHASH_H
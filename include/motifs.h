@@ -0,0 +1,44 @@
+#ifndef MOTIFS_H
+#define MOTIFS_H
+
+#include <map>
+#include <string>
+#include "graph.h"
+
+/* Temporal ARG–MGE motifs counted per patient:
+ *  - mgeSwitch:      ARG on MGE A pre-FMT and on a different MGE B post-FMT (B did not carry it pre-FMT)
+ *  - donorMgeSwitch: ARG on MGE A in the donor and on MGE B post-FMT (B did not carry it in donor or pre-FMT)
+ *  - coMoveOnto:     two ARGs arrive together on the same MGE between adjacent sampled timepoints
+ *  - coMoveOff:      two ARGs leave the same MGE together between adjacent sampled timepoints
+ * "Adjacent" follows the same per-patient chronological chain addTemporalEdges uses (donor excluded).
+ */
+struct MotifCounts {
+    long long mgeSwitch = 0;
+    long long donorMgeSwitch = 0;
+    long long coMoveOnto = 0;
+    long long coMoveOff = 0;
+
+    MotifCounts& operator+=(const MotifCounts& other) {
+        mgeSwitch      += other.mgeSwitch;
+        donorMgeSwitch += other.donorMgeSwitch;
+        coMoveOnto     += other.coMoveOnto;
+        coMoveOff      += other.coMoveOff;
+        return *this;
+    }
+};
+
+std::map<int, MotifCounts> countTemporalMotifs(const Graph& g);
+
+std::map<std::string, MotifCounts> aggregateMotifsByDisease(
+    const std::map<int, MotifCounts>& motifsByPatient,
+    const std::map<int, std::string>& patientToDiseaseMap
+);
+
+void writeMotifCountsCSV(
+    const std::map<int, MotifCounts>& motifsByPatient,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& patientCSV,
+    const std::string& diseaseCSV
+);
+
+#endif // MOTIFS_H
@@ -0,0 +1,56 @@
+#ifndef NULL_MODEL_H
+#define NULL_MODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "graph.h"
+
+/* Entity-level ARG–MGE bipartite graph as one flat edge array: row = ARG, sorted MGE columns.
+ * Row lengths are ARG degrees and column counts are MGE degrees, so degree-preserving
+ * randomization only rewrites cols in place.
+ */
+struct BipartiteEdgeArray {
+    std::vector<int> argIds;        // row -> ARG ID (ascending)
+    std::vector<int> mgeIds;        // column -> MGE ID (ascending)
+    std::vector<size_t> rowPtr;     // size = rows + 1
+    std::vector<int> cols;          // MGE columns, sorted within each row
+
+    size_t rows() const { return argIds.size(); }
+    size_t edges() const { return cols.size(); }
+};
+
+// Distinct ARG–MGE colocalizations of any timepoint
+BipartiteEdgeArray buildBipartiteEdgeArray(const Graph& g);
+
+// Curveball randomization: `trades` random row pairs exchange a random share of their non-shared columns
+void curveballRandomize(BipartiteEdgeArray& b, size_t trades, uint64_t seed);
+
+struct NullModelOptions {
+    size_t replicates = 500;
+    size_t tradesPerRow = 10;       // curveball trades per replicate = tradesPerRow * rows
+    uint64_t seed = 42;
+    unsigned int topK = 10;         // pairs among the top-K ARGs / MGEs of getTopKEntities are scored
+    size_t threads = 0;
+};
+
+// Observed value of a statistic against its degree-preserving null distribution
+struct NullModelStatistic {
+    std::string statistic;          // "butterflies", "arg_cooccurrence_pairs", "shared_mges", ...
+    std::string entityA;            // pair members for per-pair statistics, empty otherwise
+    std::string entityB;
+    double observed;
+    double nullMean;
+    double nullSD;
+    double zScore;                  // 0 when the null distribution is degenerate
+    double pValue;                  // upper tail: (1 + #{replicates >= observed}) / (1 + replicates)
+};
+
+// Replicates are independent curveball chains from the observed graph, generated in parallel with
+// one seeded stream each. Scores butterflies (2x2 bicliques, the bipartite co-occurrence motif),
+// the number of co-occurring ARG–ARG and MGE–MGE pairs, and shared partners of the top entity pairs.
+std::vector<NullModelStatistic> runDegreePreservingNullModel(const Graph& g, const NullModelOptions& options = NullModelOptions());
+
+void writeNullModelCSV(const std::vector<NullModelStatistic>& statistics, const std::string& filename);
+
+#endif // NULL_MODEL_H
@@ -0,0 +1,151 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Minimal fork-join helpers shared by the analysis modules.
+ * Work is handed out in chunks from an atomic cursor so uneven items
+ * (e.g. patients with very different numbers of colocalizations) balance out.
+ * All helpers run on one process-wide pool, which the stage scheduler submits to as well,
+ * so concurrent stages that each parallelise share the cores instead of multiplying threads.
+ */
+
+inline size_t defaultThreadCount() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<size_t>(hw);
+}
+
+// Fixed set of worker threads running submitted tasks in FIFO order; started on first use
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads) {
+        for (size_t t = 0; t < threads; ++t) workers_.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& th : workers_)
+            if (th.get_id() != std::this_thread::get_id()) th.join();
+            else th.detach();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+inline ThreadPool& sharedPool() {
+    static ThreadPool pool(defaultThreadCount());
+    return pool;
+}
+
+// Calls fn(begin, end, threadIndex) over [0, n) split into chunks.
+// threadIndex is stable per worker, so callers can keep per-thread accumulators.
+// The caller works through the chunks itself and asks the shared pool for up to threads - 1 helpers;
+// a helper that only gets a pool thread after the caller is done backs out, so a busy pool
+// (e.g. every thread running a stage) degrades to a sequential loop instead of a deadlock.
+template <typename F>
+void parallelForChunks(size_t n, F&& fn, size_t threads = 0, size_t chunk = 0) {
+    if (n == 0) return;
+    if (threads == 0) threads = defaultThreadCount();
+    threads = std::min(threads, n);
+    if (chunk == 0) chunk = std::max<size_t>(1, n / (threads * 8));
+
+    if (threads == 1) {
+        fn(size_t(0), n, size_t(0));
+        return;
+    }
+
+    // Queued helpers may outlive this call, so what they check before touching fn is shared
+    struct Join {
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t active = 0;
+        bool closed = false;
+    };
+    auto join = std::make_shared<Join>();
+    std::atomic<size_t> cursor{0};
+    auto worker = [&](size_t t) {
+        for (;;) {
+            size_t begin = cursor.fetch_add(chunk);
+            if (begin >= n) break;
+            fn(begin, std::min(n, begin + chunk), t);
+        }
+    };
+
+    for (size_t t = 1; t < threads; ++t) {
+        sharedPool().submit([join, &worker, t]() {
+            {
+                std::lock_guard<std::mutex> lock(join->mutex);
+                if (join->closed) return;
+                ++join->active;
+            }
+            worker(t);
+            std::lock_guard<std::mutex> lock(join->mutex);
+            if (--join->active == 0) join->idle.notify_all();
+        });
+    }
+    worker(0);
+
+    std::unique_lock<std::mutex> lock(join->mutex);
+    join->closed = true;
+    join->idle.wait(lock, [&]() { return join->active == 0; });
+}
+
+// Calls fn(i) for every i in [0, n)
+template <typename F>
+void parallelFor(size_t n, F&& fn, size_t threads = 0) {
+    parallelForChunks(n, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) fn(i);
+    }, threads);
+}
+
+// Number of workers parallelForChunks will use for n items
+inline size_t workerCount(size_t n, size_t threads = 0) {
+    if (threads == 0) threads = defaultThreadCount();
+    return std::max<size_t>(1, std::min(threads, n));
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,91 @@
+#ifndef POST_WINDOWS_H
+#define POST_WINDOWS_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Timepoint.h"
+
+// One post-FMT window, inclusive day range; toDay < 0 means open-ended
+struct PostWindow {
+    std::string label;
+    int fromDay;
+    int toDay;
+    std::string color;
+};
+
+// Timepoint category as the viz shows it: "donor", "pre", then one per window in day order
+struct TimepointCategoryInfo {
+    std::string name;    // timepointCategory value of the nodes
+    std::string label;   // e.g. "Post-FMT (1–30 d)"
+    std::string color;
+};
+
+// A binning scheme compiled into a lookup table indexed by timepoint ordinal (bin 0 = not in any window)
+class PostWindowScheme {
+public:
+    PostWindowScheme() = default;
+    // Throws std::invalid_argument on empty, inverted or overlapping windows
+    PostWindowScheme(std::string name, std::vector<PostWindow> windows);
+
+    const std::string& name() const { return name_; }
+    const std::vector<PostWindow>& windows() const { return windows_; }
+    int binCount() const { return static_cast<int>(windows_.size()); }
+
+    int binOf(Timepoint tp) const {
+        const int ordinal = ordinalOf(tp);
+        return ordinal < 0 ? 0 : binByOrdinal_[ordinal];
+    }
+
+    // Latest window reached by a timeline
+    int latestBin(const std::set<Timepoint>& tps) const;
+
+    // Viz category ("donor", "pre", window label) and colour of a timepoint under this scheme
+    std::string categoryName(Timepoint tp) const;
+    std::string color(Timepoint tp) const;
+
+    // Every category categoryName() can return, in timeline order ("post" only if some post-FMT day is in no window)
+    std::vector<TimepointCategoryInfo> categories() const;
+
+private:
+    std::string name_;
+    std::vector<PostWindow> windows_;     // sorted by fromDay; missing colours filled from the default ramp
+    std::vector<unsigned char> binByOrdinal_;
+};
+
+// Built-in 1–30 / 31–60 / 61+ scheme (labels post1..post3), the default when none is configured
+PostWindowScheme standardPostWindows();
+
+// Scheme used by the viz exports, centrality layers and count tables; set once at startup
+const PostWindowScheme& activePostWindows();
+void setActivePostWindows(PostWindowScheme scheme);
+
+// Several schemes evaluated together: every (scheme, window) owns one bit of a 64-bit mask
+class PostWindowSet {
+public:
+    // Throws std::invalid_argument when the schemes have more than 64 windows in total
+    explicit PostWindowSet(std::vector<PostWindowScheme> schemes);
+
+    // Windows (of every scheme) that a timeline touches, in one pass over its timepoints
+    uint64_t mask(const std::set<Timepoint>& tps) const;
+
+    const std::vector<PostWindowScheme>& schemes() const { return schemes_; }
+    size_t bitCount() const { return bitOwner_.size(); }
+    std::pair<size_t, size_t> bitOwner(size_t bit) const { return bitOwner_[bit]; }   // (scheme, window)
+
+private:
+    std::vector<PostWindowScheme> schemes_;
+    std::vector<std::pair<size_t, size_t>> bitOwner_;
+    std::vector<uint64_t> maskByOrdinal_;
+};
+
+// Per scheme, window and disease: colocalizations and patients observed in the window
+void writePostWindowSummaryCSV(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                               const std::map<int, std::string>& patientToDiseaseMap,
+                               const PostWindowSet& windowSet, const std::string& filename);
+
+#endif // POST_WINDOWS_H
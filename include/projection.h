@@ -0,0 +1,48 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "graph_analysis.h"
+
+// Row-compressed 0/1 matrix (rows = ARGs or MGEs, columns = partners or patients)
+struct SparseIncidence {
+    std::vector<int> rowEntity;        // entity ID per row
+    std::vector<size_t> rowPtr;        // size = rows + 1
+    std::vector<int> colIdx;           // sorted within each row
+
+    size_t rows() const { return rowEntity.size(); }
+};
+
+struct ProjectionEdge {
+    int a;                 // entity IDs, a < b
+    int b;
+    int sharedPartners;    // MGEs shared by two ARGs (or ARGs shared by two MGEs)
+    int sharedPatients;    // patients carrying both entities, each with any partner (not necessarily a shared one)
+};
+
+struct ProjectionOptions {
+    bool argSide = true;            // true: ARG–ARG via shared MGEs, false: MGE–MGE via shared ARGs
+    int minSharedPartners = 1;
+    int minSharedPatients = 0;
+    std::string disease;            // only count patients with this disease when non-empty
+    size_t threads = 0;
+};
+
+// Projects the bipartite colocalization network with a row-parallel SpGEMM (B * B^T, masked P * P^T)
+std::vector<ProjectionEdge> projectBipartite(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                                             const ProjectionOptions& options = {});
+
+// Projection as a weighted CompactGraph (weight = shared partners), e.g. for louvainCommunities
+CompactGraph projectionToCompact(const std::vector<ProjectionEdge>& edges, bool argSide);
+
+// SharedPatients column: see ProjectionEdge::sharedPatients
+void writeProjectionCSV(const std::vector<ProjectionEdge>& edges, bool argSide, const std::string& filename);
+
+// ARG–ARG and MGE–MGE projections for all patients and for each disease, written under outputDir
+void writeAllProjections(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                         const std::string& outputDir, int minSharedPartners = 1, int minSharedPatients = 1);
+
+#endif // PROJECTION_H
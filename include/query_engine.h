@@ -0,0 +1,109 @@
+#ifndef QUERY_ENGINE_H
+#define QUERY_ENGINE_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "graph.h"
+#include "Timepoint.h"
+
+/* Predicate queries over colocalization records (patient, ARG, MGE, timepoint):
+ *
+ *   query     := [ predicate { "and" predicate } ]
+ *   predicate := field ( "=" | "!=" ) value
+ *              | field [ "not" ] "in" "(" value { "," value } ")"
+ *   field     := arg | mge | mge_group | arg_group | disease | patient | timepoint
+ *   value     := bare word | "double-quoted string"
+ *
+ * timepoint values: donor, pre, post, a window label of the active post-FMT scheme, or a
+ * timepoint name (post_030). Keywords and fields are case-insensitive, values are not.
+ *
+ *   disease = rCDI and timepoint in (pre, post1) and mge_group != plasmid
+ */
+
+enum class QueryField { ARG, MGE, MGEGroup, ARGGroup, Disease, Patient, Timepoint };
+
+struct QueryPredicate {
+    QueryField field;
+    bool negated = false;
+    std::vector<std::string> values;
+};
+
+// Throws std::invalid_argument naming the offending position on syntax errors
+std::vector<QueryPredicate> parseQuery(const std::string& text);
+
+// One patient carrying one ARG–MGE colocalization at one timepoint
+struct ColocRecord {
+    int patient;
+    int arg;
+    int mge;
+    Timepoint timepoint;
+    const Edge* edge;
+};
+
+// How a query runs: one predicate answered from its posting lists, the rest fused into one scan
+struct QueryPlan {
+    int indexPredicate = -1;            // -1 = full scan
+    size_t estimatedRows = 0;           // rows the index scan (or full scan) visits
+    std::vector<size_t> fused;          // remaining predicates, most selective first
+    std::vector<QueryPredicate> predicates;
+    std::vector<std::vector<char>> allowed;   // per predicate, field code -> passes
+
+    std::string explain() const;
+};
+
+struct QueryResult {
+    QueryPlan plan;
+    std::vector<uint32_t> records;      // ascending record indices
+};
+
+// Records of a graph with a posting list and a code column per field; build once, query many times.
+// Records point into the graph's edges, so the graph must outlive the index.
+class QueryIndex {
+public:
+    QueryIndex(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap);
+
+    // Throws std::invalid_argument on syntax errors and on values absent from the data
+    QueryPlan compile(const std::string& text) const { return compile(parseQuery(text)); }
+    QueryPlan compile(std::vector<QueryPredicate> predicates) const;
+    QueryResult execute(const QueryPlan& plan) const;
+    QueryResult run(const std::string& text) const { return execute(compile(text)); }
+
+    size_t size() const { return records_.size(); }
+    const ColocRecord& record(size_t i) const { return records_[i]; }
+    const std::string& label(QueryField field, size_t record) const;
+
+    // Colocalization and temporal edges incident to a node
+    const std::vector<const Edge*>& edgesOf(const Node& node) const;
+
+private:
+    static constexpr size_t FIELDS = static_cast<size_t>(QueryField::Timepoint) + 1;
+
+    struct FieldIndex {
+        std::vector<std::string> labels;                            // code -> value
+        std::unordered_map<std::string, std::vector<int>> codes;    // value -> codes (names may repeat)
+        std::vector<std::vector<uint32_t>> postings;                // code -> ascending record indices
+        std::vector<int> column;                                    // record -> code
+    };
+
+    std::vector<char> allowedCodes(const QueryPredicate& predicate) const;
+    const FieldIndex& field(QueryField f) const { return fields_[static_cast<size_t>(f)]; }
+
+    std::vector<ColocRecord> records_;
+    std::vector<FieldIndex> fields_;
+    std::unordered_map<Node, std::vector<const Edge*>> edgesOf_;
+};
+
+// Matching colocalization edges plus the temporal edges between their nodes, as the filterGraphBy* helpers build;
+// induced = every edge between those nodes, as filterGraphByDisease builds
+Graph querySubgraph(const QueryIndex& index, const QueryResult& result, bool induced = false);
+
+void writeQueryResultCSV(const QueryIndex& index, const QueryResult& result, const std::string& filename);
+
+// Plan, row count and the first `limit` rows (0 = all)
+void printQueryResult(const QueryIndex& index, const QueryResult& result, std::ostream& os, size_t limit = 20);
+
+#endif // QUERY_ENGINE_H
@@ -0,0 +1,34 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/* SplitMix64: tiny, fast generator for randomized analyses (permutations, null models).
+ * Seeding one stream per work item (not per thread) keeps results independent of the thread count.
+ */
+struct SplitMix64 {
+    uint64_t state;
+
+    // Independent stream for work item `index` of a run seeded with `seed`
+    static SplitMix64 stream(uint64_t seed, uint64_t index) {
+        return SplitMix64{seed ^ (0x9e3779b97f4a7c15ULL * (index + 1))};
+    }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n) without modulo bias
+    uint64_t below(uint64_t n) {
+        const uint64_t threshold = (0 - n) % n;
+        for (;;) {
+            uint64_t x = next();
+            if (x >= threshold) return x % n;
+        }
+    }
+};
+
+#endif // RNG_H
@@ -0,0 +1,52 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <map>
+#include <string>
+#include "graph.h"
+#include "community.h"
+#include "query_engine.h"
+
+struct ServeOptions {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string unixSocket;         // listen on this Unix socket path instead of TCP when non-empty
+    size_t threads = 0;             // connection workers, 0 = hardware threads
+};
+
+struct ServiceResponse {
+    int status;
+    std::string body;               // JSON
+};
+
+/* Read-only answers over a graph indexed once (safe to call from several threads):
+ *   /health
+ *   /query?q=<predicates>&limit=<n>          matching records (default limit 1000, 0 = all)
+ *   /subgraph?q=<predicates>&induced=1       graph1.json-shaped slice
+ *   /timeline?arg=<name>  or  ?mge=<name>    partners of one entity with their timepoints and patients
+ * Query syntax as in query_engine.h; errors come back as {"error": ...} with status 400 / 404,
+ * or 500 for unexpected failures.
+ */
+class GraphService {
+public:
+    GraphService(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap, const CommunityMap& communities);
+
+    // target = path plus query string, e.g. "/subgraph?q=disease%20%3D%20rCDI"
+    ServiceResponse handle(const std::string& target) const;
+
+private:
+    ServiceResponse query(const std::map<std::string, std::string>& params) const;
+    ServiceResponse subgraph(const std::map<std::string, std::string>& params) const;
+    ServiceResponse timeline(const std::map<std::string, std::string>& params) const;
+
+    const std::map<int, std::string>& patientToDiseaseMap_;
+    const CommunityMap& communities_;
+    QueryIndex index_;
+};
+
+// Serves GraphService over HTTP/1.1 (GET only, one request per connection) until SIGINT/SIGTERM.
+// Returns 0 after such a shutdown, non-zero when the socket cannot be opened, accepting fails
+// or the platform has no POSIX sockets.
+int serveGraph(const GraphService& service, const ServeOptions& options = ServeOptions());
+
+#endif // SERVER_H
@@ -0,0 +1,48 @@
+#ifndef SIMILARITY_H
+#define SIMILARITY_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Timepoint.h"
+#include "bits.h"
+
+enum class SimilarityMetric { Jaccard, Cosine };
+
+// One bitset per patient over the (ARG, MGE) pairs seen in any profile, stored row-major
+struct PatientProfiles {
+    std::vector<int> patients;                  // sorted patient IDs, one row each
+    std::vector<std::pair<int, int>> pairs;     // column -> (ARG, MGE)
+    size_t words = 0;                           // 64-bit words per row
+    std::vector<uint64_t> bits;                 // patients.size() * words
+    std::vector<int> cardinality;               // set bits per row
+
+    const uint64_t* row(size_t i) const { return bits.data() + i * words; }
+};
+
+// timepointCategory: "donor", "pre", "post" or empty for any timepoint
+PatientProfiles buildPatientProfiles(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                     const std::string& timepointCategory = "");
+
+// All-pairs |A AND B| as a dense symmetric n x n matrix (row-major), computed in parallel cache-blocked tiles
+std::vector<int> computeIntersectionMatrix(const PatientProfiles& profiles, size_t threads = 0);
+
+// Jaccard or cosine from the intersection counts and the row cardinalities, no further bitset passes
+std::vector<double> similarityFromIntersections(const PatientProfiles& profiles, const std::vector<int>& intersections,
+                                                SimilarityMetric metric);
+
+// Both steps for a single metric
+std::vector<double> computeSimilarityMatrix(const PatientProfiles& profiles, SimilarityMetric metric, size_t threads = 0);
+
+void writeSimilarityMatrixCSV(const PatientProfiles& profiles, const std::vector<double>& matrix,
+                              const std::map<int, std::string>& patientToDiseaseMap, const std::string& filename);
+
+// Jaccard and cosine matrices for all timepoints and for each timepoint category, written under outputDir
+void writePatientSimilarity(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                            const std::map<int, std::string>& patientToDiseaseMap, const std::string& outputDir);
+
+#endif // SIMILARITY_H
@@ -0,0 +1,91 @@
+#ifndef STAGE_CACHE_H
+#define STAGE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Strings are length-prefixed so ("ab", "c") and ("a", "bc") hash differently
+inline uint64_t fnv1a64(const std::string& s, uint64_t hash = FNV_OFFSET_BASIS) {
+    const uint64_t length = s.size();
+    hash = fnv1a64(&length, sizeof(length), hash);
+    return fnv1a64(s.data(), s.size(), hash);
+}
+
+// Content hash of a file; 0 when it cannot be read
+uint64_t hashFileContents(const std::string& path);
+
+// Hash of the running executable (falls back to argv0) and the build's CONET_CODE_VERSION
+uint64_t codeVersionHash(const char* argv0);
+
+std::string hexDigest(uint64_t hash);
+
+// What a stage reads besides the run's inputs, and where it writes
+struct StageSpec {
+    std::string name;
+    std::vector<std::string> params;    // config entries the stage depends on
+    std::vector<std::string> outputs;   // files, directories or file-name prefixes (centrality_*) the stage writes
+};
+
+/* Content-addressed cache of pipeline stages.
+ * A stage's key hashes the run's base key (input data, parse flags, code version), the stage name,
+ * its parameters and its declared outputs. Files the stage writes under its outputs are recorded in
+ * <dir>/stages/<name>.json and stored once in <dir>/objects/<content hash>, together with what the
+ * stage printed to stdout. On a matching key the stage is skipped and its console output replayed:
+ * outputs that still have the recorded content are left untouched, missing or modified ones are
+ * restored from the object store. Stages with disjoint outputs may run concurrently; a file declared
+ * exactly by one stage is never attributed to another stage whose output directory contains it.
+ */
+class StageCache {
+public:
+    StageCache(std::string dir, uint64_t baseKey, bool enabled = true);
+
+    // True when the stage would be skipped: same key, every output in place or restorable
+    bool upToDate(const StageSpec& spec);
+
+    // Returns true when the stage ran, false when its outputs came from the cache
+    bool run(const StageSpec& spec, const std::function<void()>& stage);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    using Snapshot = std::map<std::string, std::pair<std::filesystem::file_time_type, uintmax_t>>;
+
+    std::string keyOf(const StageSpec& spec);
+    Snapshot snapshot(const StageSpec& spec) const;
+    bool restore(const StageSpec& spec, const std::string& key, bool apply) const;
+    void record(const StageSpec& spec, const std::string& key, const std::vector<std::string>& outputs,
+                const std::string& console) const;
+    void storeObject(uint64_t hash, const std::filesystem::path& source) const;
+
+    std::filesystem::path dir_;
+    uint64_t baseKey_;
+    bool enabled_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::string> declaredBy_;    // exact output path -> stage
+};
+
+#endif // STAGE_CACHE_H
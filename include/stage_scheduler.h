@@ -0,0 +1,43 @@
+#ifndef STAGE_SCHEDULER_H
+#define STAGE_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Runs pipeline stages as a DAG on the shared thread pool from parallel.h: a stage starts once every
+ * stage it declares in `after` has finished, so independent stages run concurrently, and the parallel
+ * loops inside them draw on the same threads rather than starting their own. Stages must only read
+ * data their dependencies produced. Each stage's stdout is buffered and printed in the order the
+ * stages were added, so the console reads the same as a sequential run.
+ */
+class StageScheduler {
+public:
+    explicit StageScheduler(size_t threads = 0);    // stages running at once, 0 = hardware threads
+
+    // Names must be unique; dependencies may be added later but must exist when run() is called
+    void add(std::string name, std::vector<std::string> after, std::function<void()> run);
+
+    // Throws std::invalid_argument on unknown dependencies or cycles. After a stage throws no new
+    // stages start; running ones finish and the first exception is rethrown.
+    void run();
+
+    size_t threads() const { return threads_; }
+
+private:
+    struct Stage {
+        std::string name;
+        std::vector<std::string> after;
+        std::function<void()> run;
+        std::vector<size_t> dependents;
+        size_t pending = 0;             // unfinished dependencies
+        bool done = false;
+        std::string console;
+    };
+
+    size_t threads_;
+    std::vector<Stage> stages_;
+};
+
+#endif // STAGE_SCHEDULER_H
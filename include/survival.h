@@ -0,0 +1,35 @@
+#ifndef SURVIVAL_H
+#define SURVIVAL_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "Timepoint.h"
+
+// One step of a Kaplan–Meier curve (day = post-FMT day of the patient's sample)
+struct KMPoint {
+    int day;
+    int atRisk;
+    int events;
+    int censored;
+    double survival;
+};
+
+// Curves keyed by analysis ("disappearance", "emergence"), group type ("All", "Disease", "MGEGroup") and group
+using KMCurves = std::map<std::string, std::map<std::string, std::map<std::string, std::vector<KMPoint>>>>;
+
+// Subjects are (patient, ARG–MGE pair) timelines over the patient's own samples:
+//   disappearance: present at pre-FMT; event = first post-FMT sample without the pair,
+//                  censored at the last post-FMT sample
+//   emergence:     absent at pre-FMT but seen in the donor or post-FMT; event = first post-FMT sample
+//                  with the pair, censored at the last post-FMT sample
+// Patients without a pre-FMT or any post-FMT sample contribute no subjects.
+KMCurves computeKaplanMeierCurves(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                  const std::map<int, std::string>& patientToDiseaseMap, size_t threads = 0);
+
+void writeKaplanMeierCSV(const KMCurves& curves, const std::string& filename);
+void writeKaplanMeierJSON(const KMCurves& curves, const std::string& filename);
+
+#endif // SURVIVAL_H
@@ -0,0 +1,79 @@
+#ifndef TEMPORAL_CLASSIFIER_H
+#define TEMPORAL_CLASSIFIER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Timepoint.h"
+
+// Donor/pre/post presence of one (patient, ARG, MGE) entry as a 3-bit pattern (8 states)
+enum TemporalPattern : unsigned {
+    InDonor   = 1u,
+    InPreFMT  = 2u,
+    InPostFMT = 4u
+};
+
+unsigned temporalPattern(const std::set<Timepoint>& tps);
+
+inline unsigned temporalPattern(bool donor, bool pre, bool post) {
+    return (donor ? InDonor : 0u) | (pre ? InPreFMT : 0u) | (post ? InPostFMT : 0u);
+}
+
+// Receives every classified entry once; finish() is called after the pass
+class TemporalDynamicsSink {
+public:
+    virtual ~TemporalDynamicsSink() = default;
+    virtual void consume(int patientID, int argID, int mgeID, unsigned pattern) = 0;
+    virtual void finish() {}
+};
+
+struct PatternLabel {
+    unsigned pattern;
+    std::string label;
+    bool append = false;    // CSV sinks: append to the file instead of rewriting it with a header
+};
+
+// Prints "Colocalizations (label): N" per pattern, in registration order
+class PatternCountSink : public TemporalDynamicsSink {
+public:
+    explicit PatternCountSink(std::vector<PatternLabel> patterns);
+    void consume(int patientID, int argID, int mgeID, unsigned pattern) override;
+    void finish() override;
+private:
+    std::vector<PatternLabel> patterns_;
+    std::vector<size_t> counts_;
+};
+
+// ARG_Name,MGE_Name,PatientCount,Label rows per pattern, written to one CSV in registration order
+class PatternCSVSink : public TemporalDynamicsSink {
+public:
+    PatternCSVSink(std::string filename, std::vector<PatternLabel> patterns);
+    void consume(int patientID, int argID, int mgeID, unsigned pattern) override;
+    void finish() override;
+private:
+    std::string filename_;
+    std::vector<PatternLabel> patterns_;
+    std::vector<std::map<std::pair<int, int>, int>> patientCounts_;
+};
+
+// Disease -> ARG–MGE -> emerged/disappeared/transferred/persisted patient counts, as JSON for the viz
+class DiseaseStatusJSONSink : public TemporalDynamicsSink {
+public:
+    DiseaseStatusJSONSink(const std::map<int, std::string>& patientToDiseaseMap, std::string jsonOutputPath, bool compact = false);
+    void consume(int patientID, int argID, int mgeID, unsigned pattern) override;
+    void finish() override;
+private:
+    const std::map<int, std::string>& patientToDiseaseMap_;
+    std::string jsonOutputPath_;
+    bool compact_;
+    std::map<std::string, std::map<std::pair<int, int>, std::map<std::string, int>>> counts_;
+};
+
+// Single pass: classify every entry once and route it to all sinks, then finish them in order
+void classifyTemporalDynamics(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                              const std::vector<TemporalDynamicsSink*>& sinks);
+
+#endif // TEMPORAL_CLASSIFIER_H
@@ -0,0 +1,263 @@
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Shared top-K selection for the prominent entity and ARG–MGE pair reports.
+ *
+ * Exact mode counts every key and keeps only the K best in a bounded min-heap,
+ * so selection costs O(n log K) instead of sorting the full frequency list.
+ * Sketch mode bounds memory for cohorts with millions of distinct keys: a
+ * SpaceSaving summary tracks the heavy hitters and a Count-Min sketch tightens
+ * their estimated counts. Results are ordered by count (descending), ties by key.
+ */
+
+enum class TopKMode {
+    Exact,
+    Sketch
+};
+
+// Hash for the key types used by the reports (ints and (ARG, MGE) pairs)
+struct TopKHash {
+    static std::size_t mix(std::uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+    }
+    std::size_t operator()(int k) const {
+        return mix(static_cast<std::uint32_t>(k));
+    }
+    std::size_t operator()(const std::pair<int, int>& k) const {
+        return mix((static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.first)) << 32) |
+                   static_cast<std::uint32_t>(k.second));
+    }
+    std::size_t operator()(const std::string& k) const {
+        return mix(std::hash<std::string>()(k));
+    }
+};
+
+// K for "keep every entry" (the "print all" report modes); K == 0 selects nothing
+inline constexpr std::size_t TOPK_ALL = static_cast<std::size_t>(-1);
+
+// Bounded heap holding the K largest (key, count) entries seen so far.
+template <typename Key, typename Count = int>
+class TopKHeap {
+public:
+    explicit TopKHeap(std::size_t K) : K_(K) {
+        if (K_ != TOPK_ALL) heap_.reserve(K_);
+    }
+
+    void push(const Key& key, Count count) {
+        if (K_ == 0) return;
+        if (heap_.size() < K_) {
+            heap_.emplace_back(key, count);
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        } else if (better(std::make_pair(key, count), heap_.front())) {
+            // Root is the weakest retained entry; replace it
+            std::pop_heap(heap_.begin(), heap_.end(), better);
+            heap_.back() = std::make_pair(key, count);
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        }
+    }
+
+    // Entries ordered best first
+    std::vector<std::pair<Key, Count>> sorted() const {
+        std::vector<std::pair<Key, Count>> out(heap_);
+        std::sort(out.begin(), out.end(), better);
+        return out;
+    }
+
+private:
+    // "a ranks above b": higher count, then smaller key for determinism
+    static bool better(const std::pair<Key, Count>& a, const std::pair<Key, Count>& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return a.first < b.first;
+    }
+
+    std::size_t K_;
+    std::vector<std::pair<Key, Count>> heap_;
+};
+
+// Select the K best entries from any range of (key, count) pairs
+template <typename Map>
+auto selectTopK(const Map& counts, std::size_t K)
+    -> std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>> {
+    TopKHeap<typename Map::key_type, typename Map::mapped_type> heap(K);
+    for (const auto& [key, count] : counts) heap.push(key, count);
+    return heap.sorted();
+}
+
+
+// Count-Min sketch: fixed depth x width table, overestimates but never underestimates
+template <typename Key>
+class CountMinSketch {
+public:
+    CountMinSketch(std::size_t width = 1 << 14, std::size_t depth = 4)
+        : width_(width), depth_(depth), table_(width * depth, 0) {}
+
+    void add(const Key& key, std::int64_t w = 1) {
+        std::size_t h = TopKHash()(key);
+        for (std::size_t d = 0; d < depth_; ++d)
+            table_[d * width_ + slot(h, d)] += w;
+    }
+
+    std::int64_t estimate(const Key& key) const {
+        std::size_t h = TopKHash()(key);
+        std::int64_t best = table_[slot(h, 0)];
+        for (std::size_t d = 1; d < depth_; ++d)
+            best = std::min(best, table_[d * width_ + slot(h, d)]);
+        return best;
+    }
+
+private:
+    std::size_t slot(std::size_t h, std::size_t d) const {
+        return TopKHash::mix(h + 0x9e3779b97f4a7c15ULL * (d + 1)) % width_;
+    }
+
+    std::size_t width_;
+    std::size_t depth_;
+    std::vector<std::int64_t> table_;
+};
+
+// SpaceSaving heavy-hitter summary over a fixed number of counters.
+// Counters live in an indexed min-heap so each update is O(log capacity).
+template <typename Key>
+class SpaceSaving {
+public:
+    struct Counter {
+        Key key;
+        std::int64_t count;
+        std::int64_t error;
+    };
+
+    explicit SpaceSaving(std::size_t capacity = 4096) : capacity_(std::max<std::size_t>(capacity, 1)) {
+        heap_.reserve(capacity_);
+    }
+
+    void add(const Key& key, std::int64_t w = 1) {
+        auto it = pos_.find(key);
+        if (it != pos_.end()) {
+            heap_[it->second].count += w;
+            siftDown(it->second);
+        } else if (heap_.size() < capacity_) {
+            heap_.push_back({key, w, 0});
+            pos_[key] = heap_.size() - 1;
+            siftUp(heap_.size() - 1);
+        } else {
+            // Evict the smallest counter; the newcomer inherits its count as error
+            Counter& root = heap_[0];
+            pos_.erase(root.key);
+            root = {key, root.count + w, root.count};
+            pos_[key] = 0;
+            siftDown(0);
+        }
+    }
+
+    const std::vector<Counter>& counters() const { return heap_; }
+
+private:
+    void swapAt(std::size_t a, std::size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        pos_[heap_[a].key] = a;
+        pos_[heap_[b].key] = b;
+    }
+    void siftUp(std::size_t i) {
+        while (i > 0) {
+            std::size_t p = (i - 1) / 2;
+            if (heap_[p].count <= heap_[i].count) break;
+            swapAt(i, p);
+            i = p;
+        }
+    }
+    void siftDown(std::size_t i) {
+        for (;;) {
+            std::size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < heap_.size() && heap_[l].count < heap_[m].count) m = l;
+            if (r < heap_.size() && heap_[r].count < heap_[m].count) m = r;
+            if (m == i) break;
+            swapAt(i, m);
+            i = m;
+        }
+    }
+
+    std::size_t capacity_;
+    std::vector<Counter> heap_;
+    std::unordered_map<Key, std::size_t, TopKHash> pos_;
+};
+
+
+// Streaming counter that answers top-K queries in either exact or sketch mode
+template <typename Key>
+class TopKCounter {
+public:
+    explicit TopKCounter(TopKMode mode = TopKMode::Exact, std::size_t sketchCapacity = 4096)
+        : mode_(mode),
+          summary_(mode == TopKMode::Sketch ? sketchCapacity : 1),
+          sketch_(mode == TopKMode::Sketch ? (1 << 14) : 1, mode == TopKMode::Sketch ? 4 : 1) {}
+
+    void add(const Key& key, int w = 1) {
+        if (mode_ == TopKMode::Exact) {
+            exact_[key] += w;
+        } else {
+            summary_.add(key, w);
+            sketch_.add(key, w);
+        }
+    }
+
+    // Number of distinct keys tracked (exact in Exact mode, bounded in Sketch mode)
+    std::size_t distinct() const {
+        return mode_ == TopKMode::Exact ? exact_.size() : summary_.counters().size();
+    }
+
+    std::vector<std::pair<Key, int>> top(std::size_t K) const {
+        if (mode_ == TopKMode::Exact) return selectTopK(exact_, K);
+
+        TopKHeap<Key, int> heap(K);
+        for (const auto& c : summary_.counters()) {
+            std::int64_t est = std::min(c.count, sketch_.estimate(c.key));
+            heap.push(c.key, static_cast<int>(est));
+        }
+        return heap.sorted();
+    }
+
+private:
+    TopKMode mode_;
+    std::unordered_map<Key, int, TopKHash> exact_;
+    SpaceSaving<Key> summary_;
+    CountMinSketch<Key> sketch_;
+};
+
+// One counter per group (disease, MGE group, ...) fed in the same pass as the global one
+template <typename Key>
+class GroupedTopK {
+public:
+    explicit GroupedTopK(TopKMode mode = TopKMode::Exact, std::size_t sketchCapacity = 4096)
+        : mode_(mode), sketchCapacity_(sketchCapacity) {}
+
+    void add(const std::string& group, const Key& key, int w = 1) {
+        auto it = groups_.find(group);
+        if (it == groups_.end())
+            it = groups_.emplace(group, TopKCounter<Key>(mode_, sketchCapacity_)).first;
+        it->second.add(key, w);
+    }
+
+    const std::map<std::string, TopKCounter<Key>>& groups() const { return groups_; }
+
+private:
+    TopKMode mode_;
+    std::size_t sketchCapacity_;
+    std::map<std::string, TopKCounter<Key>> groups_;
+};
+
+#endif // TOPK_H
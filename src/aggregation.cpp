@@ -0,0 +1,227 @@
+/* One-pass group-by counting over patientwise colocalizations with dense keys */
+#include "../include/aggregation.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include "../include/post_windows.h"
+#include "../include/temporal_classifier.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t DENSE_LIMIT = uint64_t(1) << 16;   // tables up to this many keys use flat counters
+
+using ColocIter = std::map<std::tuple<int, int, int>, std::set<Timepoint>>::const_iterator;
+
+size_t dimIndex(GroupDimension dim) { return static_cast<size_t>(dim); }
+
+// Sorted dictionary of labels; returns code per label
+std::unordered_map<std::string, int> buildDictionary(const std::set<std::string>& labels, std::vector<std::string>& dictionary) {
+    std::unordered_map<std::string, int> code;
+    dictionary.assign(labels.begin(), labels.end());
+    for (size_t i = 0; i < dictionary.size(); ++i) code[dictionary[i]] = static_cast<int>(i);
+    return code;
+}
+
+} // namespace
+
+
+std::vector<int> CountTable::decode(uint64_t key) const {
+    std::vector<int> codes;
+    decodeInto(key, codes);
+    return codes;
+}
+
+void CountTable::decodeInto(uint64_t key, std::vector<int>& codes) const {
+    codes.resize(dims.size());
+    for (size_t d = dims.size(); d-- > 0;) {
+        codes[d] = static_cast<int>(key % radix[d]);
+        key /= radix[d];
+    }
+}
+
+
+GroupByEngine::GroupByEngine(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                             const std::map<int, std::string>& patientToDiseaseMap, size_t threads)
+    : threads_(threads), columns_(DIMENSIONS), dictionaries_(DIMENSIONS) {
+    std::vector<ColocIter> entries;
+    entries.reserve(colocalizationByIndividual.size());
+    std::set<int> args, mges;
+    for (auto it = colocalizationByIndividual.begin(); it != colocalizationByIndividual.end(); ++it) {
+        entries.push_back(it);
+        args.insert(std::get<1>(it->first));
+        mges.insert(std::get<2>(it->first));
+    }
+    entries_ = entries.size();
+
+    // Entity codes in ascending ID order
+    argIds_.assign(args.begin(), args.end());
+    mgeIds_.assign(mges.begin(), mges.end());
+    std::unordered_map<int, int> argCode, mgeCode;
+    for (size_t i = 0; i < argIds_.size(); ++i) argCode[argIds_[i]] = static_cast<int>(i);
+    for (size_t i = 0; i < mgeIds_.size(); ++i) mgeCode[mgeIds_[i]] = static_cast<int>(i);
+
+    // Dictionary dimensions, resolved once per distinct entity / disease
+    std::set<std::string> diseases, mgeGroups, argGroups, resistance;
+    for (const auto& [patientID, disease] : patientToDiseaseMap) diseases.insert(disease);
+    for (int mge : mgeIds_) mgeGroups.insert(getMGEGroupName(mge));
+    auto resistanceOf = [](int arg) -> std::string {
+        auto it = argResistanceMap.find(arg);
+        return it != argResistanceMap.end() ? it->second : "Unknown";
+    };
+    for (int arg : argIds_) {
+        argGroups.insert(getARGGroupName(arg));
+        resistance.insert(resistanceOf(arg));
+    }
+
+    auto diseaseCode = buildDictionary(diseases, dictionaries_[dimIndex(GroupDimension::Disease)]);
+    auto mgeGroupCode = buildDictionary(mgeGroups, dictionaries_[dimIndex(GroupDimension::MGEGroup)]);
+    auto argGroupCode = buildDictionary(argGroups, dictionaries_[dimIndex(GroupDimension::ARGGroup)]);
+    auto resistanceCode = buildDictionary(resistance, dictionaries_[dimIndex(GroupDimension::ResistanceClass)]);
+
+    // Patients without a disease get a trailing "Unknown" code
+    const int unknownDisease = static_cast<int>(diseases.size());
+    std::unordered_map<int, int> patientDisease;
+    bool anyUnknown = false;
+    for (const auto& entry : entries) {
+        const int patientID = std::get<0>(entry->first);
+        if (patientDisease.count(patientID)) continue;
+        auto it = patientToDiseaseMap.find(patientID);
+        int code = it != patientToDiseaseMap.end() ? diseaseCode.at(it->second) : unknownDisease;
+        anyUnknown |= (code == unknownDisease);
+        patientDisease[patientID] = code;
+    }
+    if (anyUnknown) dictionaries_[dimIndex(GroupDimension::Disease)].push_back("Unknown");
+
+    std::vector<int> mgeGroupOf(mgeIds_.size()), argGroupOf(argIds_.size()), resistanceOfArg(argIds_.size());
+    for (size_t i = 0; i < mgeIds_.size(); ++i) mgeGroupOf[i] = mgeGroupCode.at(getMGEGroupName(mgeIds_[i]));
+    for (size_t i = 0; i < argIds_.size(); ++i) {
+        argGroupOf[i] = argGroupCode.at(getARGGroupName(argIds_[i]));
+        resistanceOfArg[i] = resistanceCode.at(resistanceOf(argIds_[i]));
+    }
+
+    const PostWindowScheme& windows = activePostWindows();
+    for (auto& column : columns_) column.resize(entries_);
+    parallelFor(entries_, [&](size_t i) {
+        const auto& [key, tps] = *entries[i];
+        const auto& [patientID, argID, mgeID] = key;
+        const int arg = argCode.at(argID);
+        const int mge = mgeCode.at(mgeID);
+        const unsigned pattern = temporalPattern(tps);
+        const int bin = windows.latestBin(tps);
+
+        columns_[dimIndex(GroupDimension::Disease)][i]         = patientDisease.at(patientID);
+        columns_[dimIndex(GroupDimension::MGEGroup)][i]        = mgeGroupOf[mge];
+        columns_[dimIndex(GroupDimension::ARGGroup)][i]        = argGroupOf[arg];
+        columns_[dimIndex(GroupDimension::ResistanceClass)][i] = resistanceOfArg[arg];
+        columns_[dimIndex(GroupDimension::ARG)][i]             = arg;
+        columns_[dimIndex(GroupDimension::MGE)][i]             = mge;
+        columns_[dimIndex(GroupDimension::Pattern)][i]         = static_cast<int>(pattern);
+        columns_[dimIndex(GroupDimension::Donor)][i]           = (pattern & InDonor) ? 1 : 0;
+        columns_[dimIndex(GroupDimension::PreFMT)][i]          = (pattern & InPreFMT) ? 1 : 0;
+        columns_[dimIndex(GroupDimension::PostFMT)][i]         = (pattern & InPostFMT) ? 1 : 0;
+        columns_[dimIndex(GroupDimension::PostBin)][i]         = bin;
+    }, threads_);
+}
+
+
+int GroupByEngine::cardinality(GroupDimension dim) const {
+    switch (dim) {
+        case GroupDimension::ARG:     return static_cast<int>(argIds_.size());
+        case GroupDimension::MGE:     return static_cast<int>(mgeIds_.size());
+        case GroupDimension::Pattern: return 8;
+        case GroupDimension::Donor:
+        case GroupDimension::PreFMT:
+        case GroupDimension::PostFMT: return 2;
+        case GroupDimension::PostBin: return activePostWindows().binCount() + 1;
+        default:                      return static_cast<int>(dictionaries_[dimIndex(dim)].size());
+    }
+}
+
+
+std::string GroupByEngine::label(GroupDimension dim, int code) const {
+    switch (dim) {
+        case GroupDimension::Disease:
+        case GroupDimension::MGEGroup:
+        case GroupDimension::ARGGroup:
+        case GroupDimension::ResistanceClass: return dictionaries_[dimIndex(dim)][code];
+        case GroupDimension::ARG:
+        case GroupDimension::MGE:             return std::to_string(entityId(dim, code));
+        default:                              return std::to_string(code);
+    }
+}
+
+
+int GroupByEngine::entityId(GroupDimension dim, int code) const {
+    if (dim == GroupDimension::ARG) return argIds_[code];
+    if (dim == GroupDimension::MGE) return mgeIds_[code];
+    throw std::invalid_argument("entityId: dimension is not ARG or MGE");
+}
+
+
+size_t GroupByEngine::addTable(std::vector<GroupDimension> dims) {
+    CountTable table;
+    uint64_t keys = 1;
+    for (GroupDimension dim : dims) {
+        const uint64_t r = std::max(1, cardinality(dim));
+        if (keys > std::numeric_limits<uint64_t>::max() / r)
+            throw std::overflow_error("GroupByEngine: key space exceeds 64 bits");
+        keys *= r;
+        table.radix.push_back(r);
+    }
+    table.dims = std::move(dims);
+    tables_.push_back(std::move(table));
+    return tables_.size() - 1;
+}
+
+
+void GroupByEngine::run() {
+    struct Partial {
+        std::vector<long long> dense;
+        std::unordered_map<uint64_t, long long> sparse;
+    };
+
+    std::vector<uint64_t> keySpace(tables_.size(), 1);
+    for (size_t t = 0; t < tables_.size(); ++t)
+        for (uint64_t r : tables_[t].radix) keySpace[t] *= r;
+
+    const size_t workers = workerCount(entries_, threads_);
+    std::vector<std::vector<Partial>> partials(workers, std::vector<Partial>(tables_.size()));
+    for (auto& perThread : partials)
+        for (size_t t = 0; t < tables_.size(); ++t)
+            if (keySpace[t] <= DENSE_LIMIT) perThread[t].dense.assign(keySpace[t], 0);
+
+    parallelForChunks(entries_, [&](size_t begin, size_t end, size_t w) {
+        for (size_t t = 0; t < tables_.size(); ++t) {
+            const CountTable& table = tables_[t];
+            Partial& partial = partials[w][t];
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t key = 0;
+                for (size_t d = 0; d < table.dims.size(); ++d)
+                    key = key * table.radix[d] + static_cast<uint64_t>(columns_[dimIndex(table.dims[d])][i]);
+                if (!partial.dense.empty()) partial.dense[key]++;
+                else partial.sparse[key]++;
+            }
+        }
+    }, workers);
+
+    for (size_t t = 0; t < tables_.size(); ++t) {
+        auto& counts = tables_[t].counts;
+        counts.clear();
+        if (keySpace[t] <= DENSE_LIMIT) {
+            std::vector<long long> total(keySpace[t], 0);
+            for (auto& perThread : partials)
+                for (uint64_t k = 0; k < keySpace[t]; ++k) total[k] += perThread[t].dense[k];
+            for (uint64_t k = 0; k < keySpace[t]; ++k)
+                if (total[k]) counts.emplace_back(k, total[k]);
+        } else {
+            std::unordered_map<uint64_t, long long> total;
+            for (auto& perThread : partials)
+                for (const auto& [k, c] : perThread[t].sparse) total[k] += c;
+            counts.assign(total.begin(), total.end());
+            std::sort(counts.begin(), counts.end());
+        }
+    }
+}
@@ -9,9 +9,13 @@
 #include "Timepoint.h"
 #include "analysis.h"
 #include "id_maps.h"
-#include "config_loader.h"
 #include "traversal.h"
+#include "topk.h"
+#include "temporal_classifier.h"
+#include "aggregation.h"
+#include "csv_writer.h"
 #include <filesystem>
+#include <memory>
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -19,47 +23,10 @@
 
 std::string getMGEGroupName(int id);
 namespace fs = std::filesystem;
-fs::path temporal_dynamics_emerge;
-fs::path temporal_dynamics_disappear;
-fs::path temporal_dynamics_transfer;
-fs::path temporal_dynamics_persist;
-fs::path top_entities_mge;
-fs::path top_entities_arg;
-fs::path disease_type_path;
-fs::path mge_group_path;
 
-Config cfg = loadConfig("config/paths.json");
-
-
-bool isPostFMT(const Timepoint& tp) {
-    return toString(tp).find("post") != std::string::npos;
-}
-
-bool isPreFMT(const Timepoint& tp) {
-    return toString(tp).find("pre") != std::string::npos;
-}
-
-bool isDonor(const Timepoint& tp) {
-    return toString(tp).find("donor") != std::string::npos;
-}
-
-static inline bool isPostBin1(Timepoint tp) { int v = static_cast<int>(tp); return v >= 1  && v <= 30; }
-static inline bool isPostBin2(Timepoint tp) { int v = static_cast<int>(tp); return v >= 31 && v <= 60; }
-static inline bool isPostBin3(Timepoint tp) { int v = static_cast<int>(tp); return v >= 61; }
-
-// In Post stages, highest bin wins if multiple present
-static inline int postBinOf(const std::set<Timepoint>& s) {
-    bool b1 = false, b2 = false, b3 = false;
-    for (auto tp : s) {
-        if (!b1 && isPostBin1(tp)) b1 = true;
-        else if (!b2 && isPostBin2(tp)) b2 = true;
-        else if (!b3 && isPostBin3(tp)) b3 = true;
-        if (b1 && b2 && b3) break;
-    }
-    if (b3) return 3; // post_3 (61+)
-    if (b2) return 2; // post_2 (31–60)
-    if (b1) return 1; // post_1 (1–30)
-    return 0;         // no post
+std::string sanitizeFileName(const std::string& name) {
+    static const std::regex reserved(R"([\/\\:\*\?"<>|])");
+    return std::regex_replace(name, reserved, "_");
 }
 
 /********************************* Patientwise Colocalizations ********************************/
@@ -75,19 +42,10 @@ void getPatientwiseColocalizationsByCriteria(
 ) {
     std::map<std::tuple<int, int, int>, std::set<Timepoint>> filteredColocs;
 
+    const unsigned wanted = temporalPattern(donorStatus, preFMTStatus, postFMTStatus);
     for (const auto& [tuple, tps] : colocalizationByIndividual) {
-        bool hasDonor = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp) {
-            return tp == Timepoint::Donor;
-        });
-        bool hasPreFMT = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp) {
-            return isPreFMT(tp);
-        });
-        bool hasPostFMT = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp) {
-            return isPostFMT(tp);
-        });
-
         // Match against provided pattern
-        if ((hasDonor == donorStatus) && (hasPreFMT == preFMTStatus) && (hasPostFMT == postFMTStatus)) {
+        if (temporalPattern(tps) == wanted) {
             filteredColocs.insert({tuple, tps});
         }
     }
@@ -107,20 +65,17 @@ void getTopARGMGEPairsByFrequency(
     const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizations,
     int topN // default: print all
 ) {
-    std::map<std::pair<int, int>, int> countMap;
+    TopKCounter<std::pair<int, int>> counter;
 
     // Count (ARG_ID, MGE_ID) occurrences
     for (const auto& [tuple, tps] : colocalizations) {
         int argID = std::get<0>(tuple); // Correct index: ARG is first in tuple
         int mgeID = std::get<1>(tuple); // MGE is second in tuple
-        countMap[{argID, mgeID}]++;
+        counter.add({argID, mgeID});
     }
 
-    // Convert to vector for sorting
-    std::vector<std::pair<std::pair<int, int>, int>> freqList(countMap.begin(), countMap.end());
-    std::sort(freqList.begin(), freqList.end(), [](const auto& a, const auto& b) {
-        return a.second > b.second;
-    });
+    // Bounded heap selection instead of sorting every pair
+    auto freqList = counter.top(topN > 0 ? static_cast<size_t>(topN) : TOPK_ALL);
 
     std::cout << "Top ARG–MGE pairs by frequency:\n";
     int countPrinted = 0;
@@ -146,7 +101,7 @@ void getTopARGMGEPairsByFrequency(
         countPrinted++;
     }
 
-    std::cout << "Total unique ARG–MGE pairs: " << freqList.size() << "\n";
+    std::cout << "Total unique ARG–MGE pairs: " << counter.distinct() << "\n";
 }
 
 
@@ -155,7 +110,7 @@ void getTopARGMGEPairsByFrequencyWODonor(
     int topN,
     const std::map<int, std::string>& patientToDiseaseMap, const std::string& top_colocalizations_output)
 {
-    std::map<std::pair<int, int>, int> countMap;
+    TopKCounter<std::pair<int, int>> counter;
     std::map<std::pair<int, int>, std::map<std::string, int>> diseaseCountMap;
     std::set<std::string> diseaseSet;
 
@@ -169,7 +124,7 @@ void getTopARGMGEPairsByFrequencyWODonor(
         if (!hasNonDonor) continue;
 
         auto key = std::make_pair(argID, mgeID);
-        countMap[key]++;
+        counter.add(key);
 
         std::string disease = "Unknown";
         if (patientToDiseaseMap.count(patientID))
@@ -188,12 +143,11 @@ void getTopARGMGEPairsByFrequencyWODonor(
     };
     header.insert(header.end(), diseases.begin(), diseases.end());
 
-    // Sort ARG-MGE pairs by total count
-    std::vector<std::pair<std::pair<int,int>,int>> freqList(countMap.begin(), countMap.end());
-    std::sort(freqList.begin(), freqList.end(),
-              [](auto& a, auto& b){ return a.second > b.second; });
+    // Keep only the top ARG-MGE pairs by total count
+    auto freqList = counter.top(topN > 0 ? static_cast<size_t>(topN) : TOPK_ALL);
 
-    std::vector<std::vector<std::string>> rows;
+    CsvWriter csv(top_colocalizations_output);
+    csv.headerFrom(header);
     int printed = 0;
 
     for (const auto& [pair,totalCount] : freqList) {
@@ -202,65 +156,89 @@ void getTopARGMGEPairsByFrequencyWODonor(
         int argID = pair.first;
         int mgeID = pair.second;
 
-        std::vector<std::string> row = {
-            getARGName(argID),
-            getARGGroupName(argID),
-            getMGEName(mgeID),
-            std::to_string(totalCount)
-        };
+        csv.field(getARGName(argID)).field(getARGGroupName(argID)).field(getMGEName(mgeID)).field(totalCount);
 
         for (const auto& dz : diseases) {
             int c = 0;
             if (diseaseCountMap[pair].count(dz))
                 c = diseaseCountMap[pair].at(dz);
 
-            row.push_back(std::to_string(c));
+            csv.field(c);
         }
 
-        rows.push_back(row);
+        csv.endRow();
         printed++;
     }
+    csv.close();
+}
 
-    writeCSV(top_colocalizations_output, header, rows);
+
+/* Top ARG–MGE pairs overall, per disease and per MGE group, collected in one pass (donor-only entries skipped) */
+void getTopARGMGEPairsByGroup(
+    const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizations,
+    int topN,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& outputCSV,
+    TopKMode mode)
+{
+    TopKCounter<std::pair<int, int>> overall(mode);
+    GroupedTopK<std::pair<int, int>> byDisease(mode);
+    GroupedTopK<std::pair<int, int>> byMGEGroup(mode);
+
+    for (const auto& [tuple, tps] : colocalizations) {
+        int patientID = std::get<0>(tuple);
+        int argID     = std::get<1>(tuple);
+        int mgeID     = std::get<2>(tuple);
+
+        bool hasNonDonor = std::any_of(tps.begin(), tps.end(),
+            [](const Timepoint& tp){ return tp != Timepoint::Donor; });
+        if (!hasNonDonor) continue;
+
+        auto key = std::make_pair(argID, mgeID);
+        auto it = patientToDiseaseMap.find(patientID);
+
+        overall.add(key);
+        byDisease.add(it != patientToDiseaseMap.end() ? it->second : "Unknown", key);
+        byMGEGroup.add(getMGEGroupName(mgeID), key);
+    }
+
+    size_t K = topN > 0 ? static_cast<size_t>(topN) : TOPK_ALL;
+    CsvWriter csv(outputCSV);
+    csv.header({"GroupType","Group","Rank","ARG_Name","ARG_Group","MGE_Name","Count"});
+    auto emit = [&](const std::string& groupType, const std::string& group, const TopKCounter<std::pair<int, int>>& counter) {
+        int rank = 0;
+        for (const auto& [pair, count] : counter.top(K))
+            csv.row(groupType, group, ++rank, getARGName(pair.first), getARGGroupName(pair.first), getMGEName(pair.second), count);
+    };
+
+    emit("All", "All", overall);
+    for (const auto& [disease, counter] : byDisease.groups()) emit("Disease", disease, counter);
+    for (const auto& [group, counter] : byMGEGroup.groups()) emit("MGEGroup", group, counter);
+    csv.close();
 }
 
 
-void mostProminentEntities(const Graph& g) {
+void mostProminentEntities(const Graph& g, const std::string& topARGCSV, const std::string& topMGECSV) {
     std::map<std::tuple<int, int, int>, std::set<Timepoint>> colocalizationByIndividual;
     traverseGraph(g, colocalizationByIndividual);
 
 
     std::vector<std::pair<int, int>> topARGs = getTopKEntities(g, true, static_cast<unsigned int>(10)); // Top 10 ARGs
     {
-    std::vector<std::vector<std::string>> rows;
-    for (auto& [id,count] : topARGs) {
-        rows.push_back({
-            std::to_string(id),
-            getARGName(id),
-            getARGGroupName(id),
-            std::to_string(count)
-        });
-    }
-
-    writeCSV(cfg.output_top_arg,
-        {"ARG_ID","ARG_Name","ARG_Group","Count"},
-        rows);
+    CsvWriter csv(topARGCSV);
+    csv.header({"ARG_ID","ARG_Name","ARG_Group","Count"});
+    for (auto& [id,count] : topARGs)
+        csv.row(id, getARGName(id), getARGGroupName(id), count);
+    csv.close();
     }
 
     std::vector<std::pair<int, int>> topMGEs = getTopKEntities(g, false, static_cast<unsigned int>(10)); // Top 10 MGEs 
     {
-    std::vector<std::vector<std::string>> rows;
-    for (auto& [id,count] : topMGEs) {
-        rows.push_back({
-            std::to_string(id),
-            getMGEName(id),
-            std::to_string(count)
-        });
-    }
-
-    writeCSV(cfg.output_top_mge,
-        {"MGE_ID","MGE_Name","Count"},
-        rows);
+    CsvWriter csv(topMGECSV);
+    csv.header({"MGE_ID","MGE_Name","Count"});
+    for (auto& [id,count] : topMGEs)
+        csv.row(id, getMGEName(id), count);
+    csv.close();
     }
 }
 
@@ -289,103 +267,125 @@ void getConnectedMGEs(const Graph& graph, int argID) {
 
 /***************************************** Write Functions *********************************************/
 
-/* Write temporal dynamics counts for a specific disease */
-void writeTemporalDynamicsCountsForDisease(
-    const std::string& disease,
-    std::map<std::tuple<int,int,int>,std::set<Timepoint>>& colocalizationByIndividual,
-    const std::map<int,std::string>& patientToDiseaseMap)
-{
-    std::map<std::tuple<int,int,int,int,int>,int> comboCounts;
-
-    for (auto& [key,tps] : colocalizationByIndividual) {
-        int patientID = std::get<0>(key);
-        if (!patientToDiseaseMap.count(patientID) ||
-            patientToDiseaseMap.at(patientID) != disease) continue;
+/* Disease tables: Disease x ARG x MGE x Donor x Pre x PostBin, one CSV per requested disease */
+static void writeDiseaseCountTables(const GroupByEngine& engine, size_t tableIndex, const std::set<std::string>& diseases,
+                                    const std::string& outputDir) {
+    using D = GroupDimension;
+    // Every requested disease gets a file, even without rows; rows stream straight into their file
+    std::map<std::string, std::unique_ptr<CsvWriter>> csvByDisease;
+    for (const auto& disease : diseases) {
+        auto& csv = csvByDisease[disease] = std::make_unique<CsvWriter>(outputDir + "/" + disease + ".csv");
+        csv->header({"ARG_ID","MGE_ID","Donor","Pre","Post","PatientCount"});
+    }
 
-        int argID = std::get<1>(key);
-        int mgeID = std::get<2>(key);
+    std::vector<int> c;
+    for (const auto& [key, cnt] : engine.table(tableIndex).counts) {
+        engine.table(tableIndex).decodeInto(key, c);
+        auto csv = csvByDisease.find(engine.label(D::Disease, c[0]));
+        if (csv == csvByDisease.end()) continue;
+        csv->second->row(getARGName(engine.entityId(D::ARG, c[1])), getMGEName(engine.entityId(D::MGE, c[2])),
+                         c[3], c[4], c[5], cnt);
+    }
 
-        bool donor = std::any_of(tps.begin(),tps.end(),isDonor);
-        bool pre   = std::any_of(tps.begin(),tps.end(),isPreFMT);
-        int post   = postBinOf(tps);
+    for (auto& [disease, csv] : csvByDisease) csv->close();
+}
 
-        comboCounts[{argID,mgeID,donor,pre,post}]++;
+/* MGE group tables: MGEGroup x ARG x MGE x Donor x Pre x Post, one CSV per MGE group */
+static void writeMGEGroupCountTables(const GroupByEngine& engine, size_t tableIndex, const std::string& outputDir) {
+    using D = GroupDimension;
+    // One open file per group; groups whose names sanitize to the same file share it
+    std::map<int, CsvWriter*> csvByGroup;
+    std::map<std::string, std::unique_ptr<CsvWriter>> csvByFile;
+
+    std::vector<int> c;
+    for (const auto& [key, cnt] : engine.table(tableIndex).counts) {
+        engine.table(tableIndex).decodeInto(key, c);
+        CsvWriter*& csv = csvByGroup[c[0]];
+        if (!csv) {
+// remove any filesystem-unfriendly characters not just beginning and end
+            const std::string filename = sanitizeFileName(engine.label(D::MGEGroup, c[0]));
+
+            auto& file = csvByFile[filename];
+            if (!file) {
+                file = std::make_unique<CsvWriter>(outputDir + "/"+ filename + ".csv");
+                file->header({"ARG_ID","MGE_ID","Donor","Pre","Post","PatientCount"});
+            }
+            csv = file.get();
+        }
+        csv->row(getARGName(engine.entityId(D::ARG, c[1])), getMGEName(engine.entityId(D::MGE, c[2])),
+                 c[3], c[4], c[5], cnt);
     }
 
-    std::vector<std::vector<std::string>> rows;
-    for (auto& [k,cnt] : comboCounts) {
-        int argID,mgeID,donor,pre,post;
-        std::tie(argID,mgeID,donor,pre,post)=k;
-
-        rows.push_back({
-            getARGName(argID),
-            getMGEName(mgeID),
-            std::to_string(donor),
-            std::to_string(pre),
-            std::to_string(post),
-            std::to_string(cnt)
-        });
-    }
+    for (auto& [filename, csv] : csvByFile) csv->close();
+}
+
+static const std::vector<GroupDimension> DISEASE_TABLE = {
+    GroupDimension::Disease, GroupDimension::ARG, GroupDimension::MGE,
+    GroupDimension::Donor, GroupDimension::PreFMT, GroupDimension::PostBin
+};
+
+static const std::vector<GroupDimension> MGE_GROUP_TABLE = {
+    GroupDimension::MGEGroup, GroupDimension::ARG, GroupDimension::MGE,
+    GroupDimension::Donor, GroupDimension::PreFMT, GroupDimension::PostFMT
+};
 
-    writeCSV("viz/output/disease_type/" + disease + ".csv",
-        {"ARG_ID","MGE_ID","Donor","Pre","Post","PatientCount"},
-        rows);
+
+/* Write temporal dynamics counts for a specific disease */
+void writeTemporalDynamicsCountsForDisease(
+    const std::string& disease,
+    std::map<std::tuple<int,int,int>,std::set<Timepoint>>& colocalizationByIndividual,
+    const std::map<int,std::string>& patientToDiseaseMap,
+    const std::string& outputDir)
+{
+    GroupByEngine engine(colocalizationByIndividual, patientToDiseaseMap);
+    size_t table = engine.addTable(DISEASE_TABLE);
+    engine.run();
+    writeDiseaseCountTables(engine, table, {disease}, outputDir);
 }
 
 
 /* write a CSV for all diseases */
 void writeAllDiseasesTemporalDynamicsCounts(
     std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
-    const std::map<int, std::string>& patientToDiseaseMap
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& outputDir
 ) {
+    GroupByEngine engine(colocalizationByIndividual, patientToDiseaseMap);
+    size_t table = engine.addTable(DISEASE_TABLE);
+    engine.run();
+
     std::set<std::string> diseases;
     for (const auto& [pid, dz] : patientToDiseaseMap) diseases.insert(dz);
-    for (const auto& dz : diseases)
-        writeTemporalDynamicsCountsForDisease(dz, colocalizationByIndividual, patientToDiseaseMap);
+    writeDiseaseCountTables(engine, table, diseases, outputDir);
 }
 
 
 /* Write temporal dynamics counts for a specific MGE group */
-void writeTemporalDynamicsCountsForMGEGroup(const std::map<std::tuple<int,int,int>,std::set<Timepoint>>& colocalizationByIndividual){
-    std::unordered_map<std::string,
-    std::map<std::tuple<int,int,int,int,int>,int>> groupedCounts;
-
-    for (auto& [key,tps] : colocalizationByIndividual) {
-        int argID = std::get<1>(key);
-        int mgeID = std::get<2>(key);
-        std::string group = getMGEGroupName(mgeID);
-
-        bool donor = std::any_of(tps.begin(),tps.end(),isDonor);
-        bool pre   = std::any_of(tps.begin(),tps.end(),isPreFMT);
-        bool post  = std::any_of(tps.begin(),tps.end(),isPostFMT);
+void writeTemporalDynamicsCountsForMGEGroup(const std::map<std::tuple<int,int,int>,std::set<Timepoint>>& colocalizationByIndividual,
+                                           const std::string& outputDir){
+    GroupByEngine engine(colocalizationByIndividual, {});
+    size_t table = engine.addTable(MGE_GROUP_TABLE);
+    engine.run();
+    writeMGEGroupCountTables(engine, table, outputDir);
+}
 
-        groupedCounts[group][{argID,mgeID,donor,pre,post}]++;
-    }
 
-    for (auto& [group,comboCounts] : groupedCounts) {
-        std::vector<std::vector<std::string>> rows;
-        for (auto& [k,cnt] : comboCounts) {
-            int argID,mgeID,donor,pre,post;
-            std::tie(argID,mgeID,donor,pre,post)=k;
-
-            rows.push_back({
-                getARGName(argID),
-                getMGEName(mgeID),
-                std::to_string(donor),
-                std::to_string(pre),
-                std::to_string(post),
-                std::to_string(cnt)
-            });
-        }
-// remove any filesystem-unfriendly characters not just beginning and end
-        std::string filename = group;  // copy, modifiable
-        filename = std::regex_replace(filename,std::regex(R"([\/\\:\*\?"<>|])"), "_");
-
-        writeCSV(cfg.output_mge_group + "/"+ filename + ".csv",
-            {"ARG_ID","MGE_ID","Donor","Pre","Post","PatientCount"},
-            rows);
-    }
+/* Disease and MGE group count tables from a single aggregation pass */
+void writeGroupedTemporalDynamicsCounts(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& diseaseOutputDir,
+    const std::string& mgeGroupOutputDir)
+{
+    GroupByEngine engine(colocalizationByIndividual, patientToDiseaseMap);
+    size_t diseaseTable = engine.addTable(DISEASE_TABLE);
+    size_t mgeGroupTable = engine.addTable(MGE_GROUP_TABLE);
+    engine.run();
 
+    std::set<std::string> diseases;
+    for (const auto& [pid, dz] : patientToDiseaseMap) diseases.insert(dz);
+    writeDiseaseCountTables(engine, diseaseTable, diseases, diseaseOutputDir);
+    writeMGEGroupCountTables(engine, mgeGroupTable, mgeGroupOutputDir);
 }
 
 /* Write colocalizations to a CSV file */
@@ -404,48 +404,74 @@ void writeColocalizationsToCSV(
         aggregated[{argId,mgeId}].insert(patientId);
     }
 
-    std::vector<std::vector<std::string>> rows;
-    for (auto& [pair,patients] : aggregated) {
-        rows.push_back({
-            getARGName(pair.first),
-            getMGEName(pair.second),
-            std::to_string(patients.size()),
-            label
-        });
-    }
-
-    writeCSV(filename,
-        {"ARG_Name","MGE_Name","PatientCount","Label"},
-        rows,
-        append);
+    CsvWriter csv(filename, append);
+    csv.header({"ARG_Name","MGE_Name","PatientCount","Label"});
+    for (auto& [pair,patients] : aggregated)
+        csv.row(getARGName(pair.first), getMGEName(pair.second), patients.size(), label);
+    csv.close();
 }
 
 
 /* Export colocalizations to seperate files based on temporal dynamics */
-void exportColocalizations(const Graph& g,
-    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual) 
-{
-    temporal_dynamics_emerge = fs::path(cfg.output_emerge);
-    temporal_dynamics_transfer = fs::path(cfg.output_transfer);
-    temporal_dynamics_disappear = fs::path(cfg.output_disappear);
-    temporal_dynamics_persist = fs::path(cfg.output_persist);
+static std::vector<PatternLabel> exportedPatterns() {
+    return {
+        {InPostFMT,                       "PostFMT Only"},
+        {InPreFMT,                        "PreFMT Only"},
+        {InDonor | InPreFMT,              "Donor & PreFMT Only"},
+        {InDonor | InPostFMT,             "Donor & PostFMT Only"},
+        {InPreFMT | InPostFMT,            "PreFMT & PostFMT Only"},
+        {InDonor | InPreFMT | InPostFMT,  "PreFMT, Donor & PostFMT"}
+    };
+}
+
+static std::vector<PatternCSVSink> temporalDynamicsCSVSinks(const TemporalDynamicsPaths& paths) {
+    std::vector<PatternCSVSink> sinks;
     // Emerge
-    
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        false, false, true, "PostFMT Only", temporal_dynamics_emerge.string());
+    sinks.emplace_back(paths.emerge, std::vector<PatternLabel>{
+        {InPostFMT, "PostFMT Only"}});
     // Disappear
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        false, true, false, "PreFMT Only", temporal_dynamics_disappear.string(), false);
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        true, true, false, "Donor & PreFMT Only", temporal_dynamics_disappear.string(), true);
+    sinks.emplace_back(paths.disappear, std::vector<PatternLabel>{
+        {InPreFMT, "PreFMT Only"},
+        {InDonor | InPreFMT, "Donor & PreFMT Only", true}});
     // Transfer
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        true, false, true, "Donor & PostFMT Only", temporal_dynamics_transfer.string(), true);
+    sinks.emplace_back(paths.transfer, std::vector<PatternLabel>{
+        {InDonor | InPostFMT, "Donor & PostFMT Only", true}});
     // Persist
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        false, true, true, "PreFMT & PostFMT Only", temporal_dynamics_persist.string(), false);
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual,
-        true, true, true, "PreFMT, Donor & PostFMT", temporal_dynamics_persist.string(), true);
+    sinks.emplace_back(paths.persist, std::vector<PatternLabel>{
+        {InPreFMT | InPostFMT, "PreFMT & PostFMT Only"},
+        {InDonor | InPreFMT | InPostFMT, "PreFMT, Donor & PostFMT", true}});
+    return sinks;
+}
+
+void exportColocalizations(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const TemporalDynamicsPaths& paths)
+{
+    PatternCountSink console(exportedPatterns());
+    std::vector<PatternCSVSink> csvSinks = temporalDynamicsCSVSinks(paths);
+
+    std::vector<TemporalDynamicsSink*> sinks = {&console};
+    for (auto& sink : csvSinks) sinks.push_back(&sink);
+    classifyTemporalDynamics(colocalizationByIndividual, sinks);
+}
+
+
+/* Temporal dynamics CSVs, console summary and the per-disease viz JSON from one classification pass */
+void exportTemporalDynamics(
+    const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const TemporalDynamicsPaths& paths,
+    const std::string& diseaseJsonPath,
+    bool compactJson)
+{
+    PatternCountSink console(exportedPatterns());
+    std::vector<PatternCSVSink> csvSinks = temporalDynamicsCSVSinks(paths);
+    DiseaseStatusJSONSink diseaseJson(patientToDiseaseMap, diseaseJsonPath, compactJson);
+
+    std::vector<TemporalDynamicsSink*> sinks = {&console};
+    for (auto& sink : csvSinks) sinks.push_back(&sink);
+    sinks.push_back(&diseaseJson);
+    classifyTemporalDynamics(colocalizationByIndividual, sinks);
 }
 
 
@@ -462,46 +488,27 @@ void writeGraphStatisticsCSV(
     size_t colo_edges  = std::count_if(g.edges.begin(),g.edges.end(),[](auto& e){return e.isColo;});
     size_t temporal_edges = total_edges - colo_edges;
 
-    writeCSV(filename,
-        {"TotalNodes","TotalEdges","ARGs","MGEs","ColocalizationEdges","TemporalEdges","AdjacencyNodes"},
-        {{
-            std::to_string(total_nodes),
-            std::to_string(total_edges),
-            std::to_string(arg_count),
-            std::to_string(mge_count),
-            std::to_string(colo_edges),
-            std::to_string(temporal_edges),
-            std::to_string(adjacency.size())
-        }});
+    CsvWriter csv(filename);
+    csv.header({"TotalNodes","TotalEdges","ARGs","MGEs","ColocalizationEdges","TemporalEdges","AdjacencyNodes"});
+    csv.row(total_nodes, total_edges, arg_count, mge_count, colo_edges, temporal_edges, adjacency.size());
+    csv.close();
 }
 
 
-/* Generic CSV writing function */
+/* Generic CSV writing function for rows that already exist as strings; new code streams through CsvWriter */
 void writeCSV(
     const std::string& filename,
     const std::vector<std::string>& header,
     const std::vector<std::vector<std::string>>& rows,
     bool append)
 {
-    std::ofstream out;
-    if (append)
-        out.open(filename, std::ios::app);
-    else
-        out.open(filename);
-
-    if (!out.is_open()) {
-        throw std::runtime_error("Failed to open CSV: " + filename);
-    }
-
-    if (!append) {
-        for (size_t i = 0; i < header.size(); i++)
-            out << header[i] << (i+1<header.size() ? "," : "\n");
-    }
-
+    CsvWriter csv(filename, append);
+    csv.headerFrom(header);
     for (const auto& row : rows) {
-        for (size_t i = 0; i < row.size(); i++)
-            out << row[i] << (i+1<row.size() ? "," : "\n");
+        for (const auto& cell : row) csv.field(cell);
+        csv.endRow();
     }
+    csv.close();
 }
 
 
@@ -514,13 +521,16 @@ void analyzeColocalizations(const Graph& g,
     traverseGraph(g, colocalizationByIndividual);
 
     std::cout << "Patientwise Colocalization dynamics over time:\n";
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, false, false, true, "PostFMT Only");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, false, true, false, "PreFMT Only");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, true, false, false, "Donor Only");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, true, true, false, "Donor & PreFMT Only");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, false, true, true, "PreFMT & PostFMT Only");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, true, true, true, "PreFMT, Donor & PostFMT");
-    getPatientwiseColocalizationsByCriteria(g, colocalizationByIndividual, true, false, true, "Donor & PostFMT Only");
+    PatternCountSink console({
+        {InPostFMT,                       "PostFMT Only"},
+        {InPreFMT,                        "PreFMT Only"},
+        {InDonor,                         "Donor Only"},
+        {InDonor | InPreFMT,              "Donor & PreFMT Only"},
+        {InPreFMT | InPostFMT,            "PreFMT & PostFMT Only"},
+        {InDonor | InPreFMT | InPostFMT,  "PreFMT, Donor & PostFMT"},
+        {InDonor | InPostFMT,             "Donor & PostFMT Only"}
+    });
+    classifyTemporalDynamics(colocalizationByIndividual, {&console});
 }
 
 
@@ -610,14 +620,11 @@ void getTopARGMGEPairsByUniquePatients(
     int topN,
     const std::string& label
 ) {
-    std::vector<std::pair<std::pair<int, int>, int>> freqList;
+    TopKHeap<std::pair<int, int>, int> heap(topN > 0 ? static_cast<size_t>(topN) : TOPK_ALL);
     for (const auto& [pair, patientSet] : globalPairToPatients) {
-        freqList.emplace_back(pair, patientSet.size());
+        heap.push(pair, static_cast<int>(patientSet.size()));
     }
-
-    std::sort(freqList.begin(), freqList.end(), [](const auto& a, const auto& b) {
-        return a.second > b.second;
-    });
+    auto freqList = heap.sorted();
 
     std::cout << "\nTop colocalizations by unique patients (" << label << "):\n";
     int countPrinted = 0;
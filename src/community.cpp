@@ -0,0 +1,257 @@
+/* Louvain community detection with a parallel local-moving phase */
+#include "../include/community.h"
+#include "../include/graph_utils.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+// Weighted graph for one Louvain level; selfLoop holds intra-vertex weight (both directions)
+struct LevelGraph {
+    std::vector<size_t> offsets;
+    std::vector<int> neighbors;
+    std::vector<double> weights;
+    std::vector<double> selfLoop;
+    std::vector<double> strength;
+
+    size_t size() const { return selfLoop.size(); }
+};
+
+LevelGraph fromCompact(const CompactGraph& cg) {
+    LevelGraph lg;
+    lg.offsets = cg.offsets;
+    lg.neighbors = cg.neighbors;
+    lg.weights = cg.weights;
+    lg.selfLoop.assign(cg.vertexCount(), 0.0);
+    lg.strength.assign(cg.vertexCount(), 0.0);
+    for (size_t v = 0; v < cg.vertexCount(); ++v)
+        for (size_t i = cg.offsets[v]; i < cg.offsets[v + 1]; ++i) lg.strength[v] += cg.weights[i];
+    return lg;
+}
+
+double levelModularity(const LevelGraph& lg, const std::vector<int>& comm, double m2) {
+    std::vector<double> in(lg.size(), 0.0), tot(lg.size(), 0.0);
+    for (size_t v = 0; v < lg.size(); ++v) {
+        tot[comm[v]] += lg.strength[v];
+        in[comm[v]] += lg.selfLoop[v];
+        for (size_t i = lg.offsets[v]; i < lg.offsets[v + 1]; ++i)
+            if (comm[lg.neighbors[i]] == comm[v]) in[comm[v]] += lg.weights[i];
+    }
+    double q = 0.0;
+    for (size_t c = 0; c < lg.size(); ++c)
+        if (tot[c] > 0.0) q += in[c] / m2 - (tot[c] / m2) * (tot[c] / m2);
+    return q;
+}
+
+// Relabels communities to 0..k-1 in order of first appearance; returns k
+int renumber(std::vector<int>& comm) {
+    std::vector<int> remap(comm.size(), -1);
+    int next = 0;
+    for (int& c : comm) {
+        if (remap[c] < 0) remap[c] = next++;
+        c = remap[c];
+    }
+    return next;
+}
+
+// Community v gains most modularity by joining, ties to the lower label, and that gain over staying put.
+// acc/seen are per-thread scratch; acc is all zero again on return.
+std::pair<int, double> bestCommunity(const LevelGraph& lg, double m2, size_t v, const std::vector<int>& comm,
+                                     const std::vector<double>& tot, std::vector<double>& acc, std::vector<int>& seen) {
+    seen.clear();
+    for (size_t i = lg.offsets[v]; i < lg.offsets[v + 1]; ++i) {
+        int c = comm[lg.neighbors[i]];
+        if (acc[c] == 0.0) seen.push_back(c);
+        acc[c] += lg.weights[i];
+    }
+
+    const int own = comm[v];
+    const double kv = lg.strength[v];
+    const double stay = acc[own] - (tot[own] - kv) * kv / m2;
+    int best = own;
+    double bestGain = stay;
+    for (int c : seen) {
+        if (c == own) continue;
+        double gain = acc[c] - tot[c] * kv / m2;
+        if (gain > bestGain + 1e-12 || (gain > bestGain - 1e-12 && c < best)) {
+            best = c;
+            bestGain = gain;
+        }
+    }
+    for (int c : seen) acc[c] = 0.0;
+    return {best, bestGain - stay};
+}
+
+// Sequential fallback for a batch that did not raise modularity: its movers are re-evaluated one at a time
+// against the current state and moved only on a strictly positive gain, so every applied move helps
+size_t moveSequentially(const LevelGraph& lg, double m2, const std::vector<int>& proposal, std::vector<int>& comm,
+                        std::vector<double>& tot, std::vector<double>& acc, std::vector<int>& seen) {
+    size_t applied = 0;
+    for (size_t v = 0; v < lg.size(); ++v) {
+        if (proposal[v] == comm[v]) continue;
+        const auto [best, gain] = bestCommunity(lg, m2, v, comm, tot, acc, seen);
+        if (best == comm[v] || gain <= 1e-12) continue;
+        tot[comm[v]] -= lg.strength[v];
+        tot[best] += lg.strength[v];
+        comm[v] = best;
+        ++applied;
+    }
+    return applied;
+}
+
+// Parallel local moving: every vertex proposes its best community against a snapshot,
+// then moves are applied under an alternating min/max-label rule so swaps cannot oscillate;
+// a batch that would lower modularity falls back to sequential moves before the sweep counts as idle.
+std::vector<int> localMoving(const LevelGraph& lg, double m2, const CommunityOptions& options) {
+    const size_t n = lg.size();
+    std::vector<int> comm(n);
+    std::iota(comm.begin(), comm.end(), 0);
+    std::vector<double> tot(lg.strength);
+    std::vector<int> proposal(n);
+
+    const size_t workers = workerCount(n, options.threads);
+    std::vector<std::vector<double>> scratch(workers, std::vector<double>(n, 0.0));
+    std::vector<std::vector<int>> touched(workers);
+
+    double quality = levelModularity(lg, comm, m2);
+    int idleSweeps = 0;
+
+    for (int sweep = 0; sweep < options.maxSweeps && idleSweeps < 2; ++sweep) {
+        parallelForChunks(n, [&](size_t begin, size_t end, size_t t) {
+            for (size_t v = begin; v < end; ++v)
+                proposal[v] = bestCommunity(lg, m2, v, comm, tot, scratch[t], touched[t]).first;
+        }, workers);
+
+        const bool towardSmaller = (sweep % 2 == 0);
+        std::vector<int> next(comm);
+        size_t moved = 0, proposed = 0;
+        for (size_t v = 0; v < n; ++v) {
+            if (proposal[v] == comm[v]) continue;
+            ++proposed;
+            if ((proposal[v] < comm[v]) == towardSmaller) {
+                next[v] = proposal[v];
+                ++moved;
+            }
+        }
+
+        double nextQuality = moved ? levelModularity(lg, next, m2) : quality;
+        if (moved && nextQuality > quality) {
+            idleSweeps = (nextQuality - quality < options.minGain) ? idleSweeps + 1 : 0;
+            comm.swap(next);
+            quality = nextQuality;
+            std::fill(tot.begin(), tot.end(), 0.0);
+            for (size_t v = 0; v < n; ++v) tot[comm[v]] += lg.strength[v];
+        } else if (proposed && moveSequentially(lg, m2, proposal, comm, tot, scratch[0], touched[0])) {
+            // Conflicting batch: the good moves in it are kept one vertex at a time
+            nextQuality = levelModularity(lg, comm, m2);
+            idleSweeps = (nextQuality - quality < options.minGain) ? idleSweeps + 1 : 0;
+            quality = nextQuality;
+        } else {
+            ++idleSweeps;
+        }
+    }
+    return comm;
+}
+
+LevelGraph aggregate(const LevelGraph& lg, const std::vector<int>& comm, int k) {
+    LevelGraph coarse;
+    coarse.selfLoop.assign(k, 0.0);
+    coarse.strength.assign(k, 0.0);
+
+    std::vector<std::tuple<int, int, double>> arcs;
+    for (size_t v = 0; v < lg.size(); ++v) {
+        int c = comm[v];
+        coarse.selfLoop[c] += lg.selfLoop[v];
+        coarse.strength[c] += lg.strength[v];
+        for (size_t i = lg.offsets[v]; i < lg.offsets[v + 1]; ++i) {
+            int d = comm[lg.neighbors[i]];
+            if (c == d) coarse.selfLoop[c] += lg.weights[i];
+            else arcs.emplace_back(c, d, lg.weights[i]);
+        }
+    }
+    std::sort(arcs.begin(), arcs.end());
+
+    coarse.offsets.assign(k + 1, 0);
+    for (size_t i = 0; i < arcs.size(); ++i) {
+        auto [c, d, w] = arcs[i];
+        if (!coarse.neighbors.empty() && i > 0 && std::get<0>(arcs[i - 1]) == c && std::get<1>(arcs[i - 1]) == d) {
+            coarse.weights.back() += w;
+            continue;
+        }
+        coarse.neighbors.push_back(d);
+        coarse.weights.push_back(w);
+        coarse.offsets[c + 1]++;
+    }
+    std::partial_sum(coarse.offsets.begin(), coarse.offsets.end(), coarse.offsets.begin());
+    return coarse;
+}
+
+} // namespace
+
+
+double computeModularity(const CompactGraph& cg, const std::vector<int>& community) {
+    LevelGraph lg = fromCompact(cg);
+    double m2 = std::accumulate(lg.strength.begin(), lg.strength.end(), 0.0);
+    if (m2 == 0.0) return 0.0;
+    std::vector<int> comm(community);
+    renumber(comm);
+    return levelModularity(lg, comm, m2);
+}
+
+
+CommunityResult louvainCommunities(const CompactGraph& cg, const CommunityOptions& options) {
+    CommunityResult result;
+    const size_t n = cg.vertexCount();
+    result.community.resize(n);
+    std::iota(result.community.begin(), result.community.end(), 0);
+    if (n == 0) return result;
+
+    LevelGraph lg = fromCompact(cg);
+    const double m2 = std::accumulate(lg.strength.begin(), lg.strength.end(), 0.0);
+    if (m2 == 0.0) {
+        result.communityCount = static_cast<int>(n);
+        return result;
+    }
+
+    for (int level = 0; level < options.maxLevels; ++level) {
+        std::vector<int> comm = localMoving(lg, m2, options);
+        int k = renumber(comm);
+        for (int& c : result.community) c = comm[c];
+        result.levels = level + 1;
+        if (static_cast<size_t>(k) == lg.size()) break;
+        lg = aggregate(lg, comm, k);
+    }
+
+    result.communityCount = renumber(result.community);
+    result.modularity = computeModularity(cg, result.community);
+    return result;
+}
+
+
+CommunityMap detectCommunities(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                               const CommunityOptions& options) {
+    // Only copy the graph when a restriction is requested
+    const Graph* source = &g;
+    Graph subgraph;
+    if (!options.disease.empty()) {
+        subgraph = filterGraphByDisease(*source, options.disease, patientToDiseaseMap);
+        source = &subgraph;
+    }
+    if (!options.timepointCategory.empty()) {
+        subgraph = filterGraphByTimepoint(*source, options.timepointCategory);
+        source = &subgraph;
+    }
+
+    CompactGraph cg = buildColocalizationCSR(*source);
+    CommunityResult result = louvainCommunities(cg, options);
+
+    std::cout << "Communities: " << result.communityCount
+              << " (modularity " << result.modularity << ", levels " << result.levels << ")\n";
+
+    CommunityMap communities;
+    for (size_t v = 0; v < cg.vertexCount(); ++v)
+        communities[{cg.entityId[v], cg.isARG[v]}] = result.community[v];
+    return communities;
+}
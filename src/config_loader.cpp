@@ -29,10 +29,72 @@ Config loadConfig(const std::string& filename) {
     cfg.output_top_arg              = te.at("top_arg").get<std::string>();
     cfg.output_top_mge              = te.at("top_mge").get<std::string>();
     cfg.output_top_colocalizations  = te.at("top_colocalizations").get<std::string>();
+    cfg.output_top_colocalizations_by_group = te.at("top_colocalizations_by_group").get<std::string>();
+    cfg.output_centrality_prefix    = te.at("centrality").get<std::string>();
+
+    auto motifs = output.at("motifs");
+    cfg.output_motifs_patient = motifs.at("per_patient").get<std::string>();
+    cfg.output_motifs_disease = motifs.at("per_disease").get<std::string>();
+
+    auto projections = output.at("projections");
+    cfg.output_projections              = projections.at("dir").get<std::string>();
+    cfg.projection_min_shared_partners  = projections.at("min_shared_partners").get<int>();
+    cfg.projection_min_shared_patients  = projections.at("min_shared_patients").get<int>();
+
+    cfg.output_similarity = output.at("similarity").get<std::string>();
+    cfg.output_similar_patients = output.at("similar_patients").get<std::string>();
+    cfg.output_survival = output.at("survival").get<std::string>();
+    cfg.output_post_windows = output.at("post_windows").get<std::string>();
+
+    auto enrichment = output.at("enrichment");
+    cfg.output_enrichment        = enrichment.at("file").get<std::string>();
+    cfg.enrichment_permutations  = enrichment.at("permutations").get<int>();
+    cfg.enrichment_seed          = enrichment.at("seed").get<int>();
+    cfg.enrichment_min_patients  = enrichment.at("min_patients").get<int>();
+
+    auto nullModel = output.at("null_model");
+    cfg.output_null_model          = nullModel.at("file").get<std::string>();
+    cfg.null_model_replicates      = nullModel.at("replicates").get<int>();
+    cfg.null_model_trades_per_row  = nullModel.at("trades_per_row").get<int>();
+    cfg.null_model_seed            = nullModel.at("seed").get<int>();
+    cfg.null_model_top_k           = nullModel.at("top_k").get<int>();
+
+    auto windows = j.at("post_fmt_windows");
+    cfg.active_post_windows = windows.at("active").get<std::string>();
+    for (const auto& [name, defs] : windows.at("schemes").items()) {
+        std::vector<PostWindow> scheme;
+        for (const auto& w : defs) {
+            scheme.push_back({
+                w.at("label").get<std::string>(),
+                w.at("from").get<int>(),
+                w.value("to", -1),
+                w.value("color", std::string())
+            });
+        }
+        cfg.post_window_schemes.emplace_back(name, std::move(scheme));
+    }
 
     cfg.viz_interaction        = j.at("viz").at("interaction_json").get<std::string>();
     cfg.viz_parent             = j.at("viz").at("parent_json").get<std::string>();
+    cfg.viz_parent_shards      = j.at("viz").at("parent_shards_dir").get<std::string>();
+    cfg.viz_coarse             = j.at("viz").at("coarse_json").get<std::string>();
+    cfg.viz_coarse_arg_level   = j.at("viz").at("coarse_arg_level").get<std::string>();
+    cfg.viz_coarse_mge_level   = j.at("viz").at("coarse_mge_level").get<std::string>();
     cfg.viz_temporal_dynamics  = j.at("viz").at("temporal_dynamics_disease").get<std::string>();
+    cfg.viz_survival           = j.at("viz").at("survival_json").get<std::string>();
+    cfg.viz_compact_json       = j.at("viz").at("compact_json").get<bool>();
+    cfg.viz_graph_schema       = j.at("viz").at("graph_schema").get<std::string>();
+
+    const auto& layout = j.at("layout");
+    cfg.layout_enabled    = layout.at("enabled").get<bool>();
+    cfg.layout_iterations = layout.at("iterations").get<int>();
+    cfg.layout_seed       = layout.at("seed").get<int>();
+    cfg.layout_theta      = layout.at("theta").get<double>();
+
+    cfg.cache_dir      = j.at("cache").at("dir").get<std::string>();
+    cfg.cache_enabled  = j.at("cache").at("enabled").get<bool>();
+
+    cfg.scheduler_threads = j.at("scheduler").at("threads").get<int>();
 
     return cfg;
 }
@@ -53,6 +115,38 @@ void createOutputDirectories(const Config& cfg) {
     create_directories(path(cfg.output_top_arg).parent_path());
     create_directories(path(cfg.output_top_mge).parent_path());
     create_directories(path(cfg.output_top_colocalizations).parent_path());
+    create_directories(path(cfg.output_top_colocalizations_by_group).parent_path());
+    create_directories(path(cfg.output_centrality_prefix).parent_path());
+
+    // motif tables
+    create_directories(path(cfg.output_motifs_patient).parent_path());
+    create_directories(path(cfg.output_motifs_disease).parent_path());
+
+    // bipartite projections
+    create_directories(cfg.output_projections);
+
+    // patient similarity matrices
+    create_directories(cfg.output_similarity);
+    create_directories(path(cfg.output_similar_patients).parent_path());
+
+    // survival curves
+    create_directories(path(cfg.output_survival).parent_path());
+    create_directories(path(cfg.viz_survival).parent_path());
+
+    // sharded colocalization view
+    create_directories(cfg.viz_parent_shards);
+
+    // post-FMT window summary
+    create_directories(path(cfg.output_post_windows).parent_path());
+
+    // disease enrichment tests
+    create_directories(path(cfg.output_enrichment).parent_path());
+
+    // degree-preserving null model
+    create_directories(path(cfg.output_null_model).parent_path());
+
+    // stage cache
+    if (cfg.cache_enabled) create_directories(cfg.cache_dir);
 
 }
 
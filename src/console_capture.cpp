@@ -0,0 +1,62 @@
+/* Per-thread capture of std::cout through a routing stream buffer installed once */
+#include "../include/console_capture.h"
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+
+namespace {
+thread_local ConsoleCapture* currentCapture = nullptr;
+}
+
+// Unbuffered, so every write is routed by the thread that made it
+class ConsoleRouter : public std::streambuf {
+public:
+    explicit ConsoleRouter(std::streambuf* terminal) : terminal_(terminal) {}
+
+protected:
+    int overflow(int c) override {
+        if (c == traits_type::eof()) return traits_type::not_eof(c);
+        const char ch = static_cast<char>(c);
+        if (ConsoleCapture::route(&ch, 1)) return terminal_->sputc(ch);
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (ConsoleCapture::route(s, static_cast<size_t>(n))) return terminal_->sputn(s, n);
+        return n;
+    }
+    int sync() override { return terminal_->pubsync(); }
+
+private:
+    std::streambuf* terminal_;
+};
+
+
+bool ConsoleCapture::route(const char* s, size_t n) {
+    bool toTerminal = true;
+    for (ConsoleCapture* c = currentCapture; c; c = c->outer_) {
+        c->text_.append(s, n);
+        toTerminal = toTerminal && c->passThrough_;
+    }
+    return toTerminal;
+}
+
+
+void ConsoleCapture::install() {
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        std::cout.flush();
+        // Never freed: std::cout is still flushed during static destruction
+        std::cout.rdbuf(new ConsoleRouter(std::cout.rdbuf()));
+    });
+}
+
+
+ConsoleCapture::ConsoleCapture(bool passThrough) : passThrough_(passThrough), outer_(currentCapture) {
+    install();
+    currentCapture = this;
+}
+
+
+ConsoleCapture::~ConsoleCapture() {
+    currentCapture = outer_;
+}
@@ -0,0 +1,145 @@
+/* Buffered streaming CSV writer */
+#include "../include/csv_writer.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+CsvWriter::CsvWriter(const std::string& filename, bool append, CsvWriterOptions options)
+    : filename_(filename), append_(append), options_(options)
+{
+    file_ = std::fopen(filename.c_str(), append ? "ab" : "wb");
+    if (!file_) throw std::runtime_error("Failed to open CSV: " + filename);
+    // Blocks are already large; skip stdio's own copy
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    if (options_.bufferSize == 0) options_.bufferSize = 1;
+    buffer_.reserve(options_.bufferSize + 256);
+    if (options_.backgroundFlush) {
+        pending_.reserve(options_.bufferSize + 256);
+        writer_ = std::thread(&CsvWriter::writerLoop, this);
+    }
+}
+
+
+CsvWriter::~CsvWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // close() reports write errors to callers that ask; a destructor cannot
+    }
+}
+
+
+CsvWriter& CsvWriter::header(std::initializer_list<std::string_view> names) {
+    return headerFrom(names);
+}
+
+
+CsvWriter& CsvWriter::field(std::string_view value) {
+    separate();
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer_.append(value);
+        return *this;
+    }
+    buffer_ += '"';
+    for (char c : value) {
+        if (c == '"') buffer_ += '"';
+        buffer_ += c;
+    }
+    buffer_ += '"';
+    return *this;
+}
+
+
+CsvWriter& CsvWriter::field(double value) {
+    separate();
+    char digits[64];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+    if (result.ec == std::errc()) buffer_.append(digits, result.ptr);
+    else buffer_ += std::to_string(value);     // beyond 64 characters (|value| > 1e56)
+    return *this;
+}
+
+
+CsvWriter& CsvWriter::endRow() {
+    buffer_ += '\n';
+    rowOpen_ = false;
+    ++rows_;
+    if (buffer_.size() >= options_.bufferSize) flushBuffer();
+    return *this;
+}
+
+
+void CsvWriter::writeBlock(const std::string& block) {
+    if (block.empty()) return;
+    if (std::fwrite(block.data(), 1, block.size(), file_) != block.size())
+        throw std::runtime_error("Failed to write CSV: " + filename_ + ": " + std::strerror(errno));
+}
+
+
+void CsvWriter::flushBuffer() {
+    if (!options_.backgroundFlush) {
+        writeBlock(buffer_);
+        buffer_.clear();
+        return;
+    }
+
+    // Hand the full buffer over and keep formatting into the one the writer finished with
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [&]() { return !pendingFull_; });
+    if (writeError_) std::rethrow_exception(writeError_);
+    pending_.swap(buffer_);
+    pendingFull_ = true;
+    changed_.notify_all();
+    lock.unlock();
+    buffer_.clear();
+}
+
+
+void CsvWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [&]() { return pendingFull_ || stopping_; });
+        if (!pendingFull_) return;
+
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            writeBlock(pending_);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !writeError_) writeError_ = error;
+        pending_.clear();
+        pendingFull_ = false;
+        changed_.notify_all();
+    }
+}
+
+
+void CsvWriter::close() {
+    if (!file_) return;
+    if (rowOpen_) endRow();
+
+    std::exception_ptr error;
+    try {
+        flushBuffer();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        writer_.join();
+        if (!error) error = writeError_;
+    }
+
+    const bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    if (error) std::rethrow_exception(error);
+    if (!closed) throw std::runtime_error("Failed to close CSV: " + filename_);
+}
@@ -0,0 +1,169 @@
+/* Label-permutation tests of ARG–MGE pair enrichment per disease over patient bitsets */
+#include "../include/enrichment.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include "../include/rng.h"
+#include "../include/similarity.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t PAIR_BLOCK = 64;   // pairs sharing one sweep over the permutation masks
+
+void benjaminiHochberg(std::vector<EnrichmentResult>& results) {
+    const size_t m = results.size();
+    std::vector<size_t> order(m);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return results[a].pValue < results[b].pValue; });
+
+    double running = 1.0;
+    for (size_t i = m; i-- > 0;) {
+        running = std::min(running, results[order[i]].pValue * static_cast<double>(m) / static_cast<double>(i + 1));
+        results[order[i]].qValue = running;
+    }
+}
+
+} // namespace
+
+
+std::vector<EnrichmentResult> runDiseaseEnrichment(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                                   const std::map<int, std::string>& patientToDiseaseMap,
+                                                   const EnrichmentOptions& options) {
+    // Patients and their disease codes; patients missing from the map are labelled "Unknown"
+    std::vector<int> patients;
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        const int patientID = std::get<0>(key);
+        if (patients.empty() || patients.back() != patientID) patients.push_back(patientID);
+    }
+    std::set<std::string> diseaseSet;
+    for (int patientID : patients) {
+        auto it = patientToDiseaseMap.find(patientID);
+        diseaseSet.insert(it != patientToDiseaseMap.end() ? it->second : "Unknown");
+    }
+    const std::vector<std::string> diseases(diseaseSet.begin(), diseaseSet.end());
+    std::unordered_map<std::string, int> diseaseCode;
+    for (size_t d = 0; d < diseases.size(); ++d) diseaseCode[diseases[d]] = static_cast<int>(d);
+
+    const size_t n = patients.size();
+    const size_t D = diseases.size();
+    const size_t W = (n + 63) / 64;
+    std::vector<int> labels(n);
+    std::unordered_map<int, size_t> patientIndex;
+    for (size_t i = 0; i < n; ++i) {
+        auto it = patientToDiseaseMap.find(patients[i]);
+        labels[i] = diseaseCode.at(it != patientToDiseaseMap.end() ? it->second : "Unknown");
+        patientIndex[patients[i]] = i;
+    }
+
+    // One carrier bitset per pair; donor-only entries do not count, as in the frequency tables
+    std::map<std::pair<int, int>, std::vector<uint64_t>> carrierBits;
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        const auto& [patientID, argID, mgeID] = key;
+        if (std::all_of(tps.begin(), tps.end(), [](Timepoint tp) { return isDonor(tp); })) continue;
+        auto& bits = carrierBits[{argID, mgeID}];
+        if (bits.empty()) bits.assign(W, 0);
+        const size_t i = patientIndex.at(patientID);
+        bits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<uint64_t> rows;
+    std::vector<int> carriers;
+    for (const auto& [pair, bits] : carrierBits) {
+        int c = 0;
+        for (uint64_t word : bits) c += popcount64(word);
+        if (c < options.minPatients) continue;
+        pairs.push_back(pair);
+        rows.insert(rows.end(), bits.begin(), bits.end());
+        carriers.push_back(c);
+    }
+    const size_t P = pairs.size();
+
+    // Observed carriers per (pair, disease) under the true labels
+    std::vector<uint64_t> trueMasks(D * W, 0);
+    for (size_t i = 0; i < n; ++i) trueMasks[labels[i] * W + i / 64] |= uint64_t(1) << (i % 64);
+    std::vector<int> observed(P * D, 0);
+    for (size_t r = 0; r < P; ++r)
+        for (size_t d = 0; d < D; ++d)
+            for (size_t w = 0; w < W; ++w) observed[r * D + d] += popcount64(rows[r * W + w] & trueMasks[d * W + w]);
+
+    // Disease masks of every permutation, D * W words each
+    const size_t K = options.permutations;
+    std::vector<uint64_t> permMasks(K * D * W, 0);
+    parallelFor(K, [&](size_t k) {
+        SplitMix64 rng = SplitMix64::stream(options.seed, k);
+        std::vector<int> shuffled(labels);
+        for (size_t i = n; i > 1; --i) std::swap(shuffled[i - 1], shuffled[rng.below(i)]);
+        uint64_t* masks = permMasks.data() + k * D * W;
+        for (size_t i = 0; i < n; ++i) masks[shuffled[i] * W + i / 64] |= uint64_t(1) << (i % 64);
+    }, options.threads);
+
+    // Exceedance counts: blocks of pairs stay in cache while the permutation masks stream past
+    std::vector<int> exceed(P * D, 0);
+    const size_t blocks = (P + PAIR_BLOCK - 1) / PAIR_BLOCK;
+    parallelFor(blocks, [&](size_t b) {
+        const size_t r0 = b * PAIR_BLOCK, r1 = std::min(P, r0 + PAIR_BLOCK);
+        for (size_t k = 0; k < K; ++k) {
+            const uint64_t* masks = permMasks.data() + k * D * W;
+            for (size_t r = r0; r < r1; ++r) {
+                const uint64_t* row = rows.data() + r * W;
+                for (size_t d = 0; d < D; ++d) {
+                    const int obs = observed[r * D + d];
+                    if (obs == 0) continue;   // always exceeded; p = 1
+                    int count = 0;
+                    for (size_t w = 0; w < W; ++w) count += popcount64(row[w] & masks[d * W + w]);
+                    exceed[r * D + d] += (count >= obs);
+                }
+            }
+        }
+    }, options.threads);
+
+    std::vector<int> groupSize(D, 0);
+    for (int label : labels) groupSize[label]++;
+
+    std::vector<EnrichmentResult> results;
+    results.reserve(P * D);
+    for (size_t r = 0; r < P; ++r) {
+        for (size_t d = 0; d < D; ++d) {
+            const int obs = observed[r * D + d];
+            const size_t hits = obs == 0 ? K : static_cast<size_t>(exceed[r * D + d]);
+            results.push_back({
+                pairs[r].first,
+                pairs[r].second,
+                diseases[d],
+                carriers[r],
+                obs,
+                static_cast<double>(carriers[r]) * groupSize[d] / static_cast<double>(n),   // hypergeometric mean
+                static_cast<double>(1 + hits) / static_cast<double>(1 + K),
+                1.0
+            });
+        }
+    }
+    benjaminiHochberg(results);
+
+    std::sort(results.begin(), results.end(), [](const EnrichmentResult& a, const EnrichmentResult& b) {
+        return std::tie(a.qValue, a.pValue, a.argID, a.mgeID, a.disease) <
+               std::tie(b.qValue, b.pValue, b.argID, b.mgeID, b.disease);
+    });
+
+    const auto significant = std::count_if(results.begin(), results.end(), [](const EnrichmentResult& e) { return e.qValue < 0.05; });
+    std::cout << "Disease enrichment: " << results.size() << " tests over " << P << " pairs, "
+              << K << " permutations, " << significant << " with q < 0.05\n";
+    return results;
+}
+
+
+void writeEnrichmentCSV(const std::vector<EnrichmentResult>& results, const std::string& filename) {
+    CsvWriter csv(filename);
+    csv.header({"ARG_Name","ARG_Group","MGE_Name","Disease","Carriers","Observed","Expected","PValue","QValue"});
+    for (const EnrichmentResult& e : results) {
+        csv.row(getARGName(e.argID), getARGGroupName(e.argID), getMGEName(e.mgeID), e.disease,
+                e.carriers, e.observed, e.expected, e.pValue, e.qValue);
+    }
+    csv.close();
+}
@@ -8,6 +8,7 @@
 #include "graph.h"
 #include "id_maps.h"
 #include "export.h"
+#include "post_windows.h"
 
 std::string getNodeName(const Node& node) {
     std::string name = "N_" + std::to_string(node.id);
@@ -23,13 +24,8 @@ std::string getNodeLabel(const Node& node) {
 }
 
 std::string getTimepointColor(const Timepoint& tp) {
-    int timeValue = static_cast<int>(tp);
-    if (timeValue == 1000) return "\"yellow\"";
-    if (timeValue == 0)  return "\"red\"";
-    if (timeValue > 0 && timeValue < 31) return "\"#99D2FF\""; 
-    if (timeValue > 30 && timeValue < 61) return "\"#4D9DFF\""; 
-    if (timeValue > 60) return "\"#3A6EFF\"";
-    return "\"green\""; // Fallback for any unexpected values
+    // Quoted for DOT attributes
+    return "\"" + activePostWindows().color(tp) + "\"";
 }
 
 bool isTemporalEdge(const Edge& edge) {
@@ -3,8 +3,12 @@
 #include <string>
 #include <filesystem>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <set> 
+#include <unordered_map>
 #include "../include/graph.h"
 #include "../include/id_maps.h"
 #include "../include/export.h"
@@ -13,49 +17,105 @@
 #include "../include/Timepoint.h"
 #include "../include/analysis.h"
 #include "../include/parser.h" 
+#include "../include/export_graph_json.h"
+#include "../include/json_writer.h"
+#include "../include/temporal_classifier.h"
+#include "../include/post_windows.h"
+#include "../include/parallel.h"
+#include "../include/graph_utils.h"
 
 using nlohmann::json;
 namespace fs = std::filesystem;
 
 
-static std::string getTimepointColor(const Timepoint& tp) {
-    int timeValue = static_cast<int>(tp);
-    if (timeValue == 1000) return "yellow";
-    if (timeValue == 0)    return "red";
-    if (timeValue > 0 && timeValue < 31) return "#99D2FF";
-    if (timeValue > 30 && timeValue < 61) return "#4D9DFF";
-    if (timeValue > 60)    return "#3A6EFF";
-    return "green"; // fallback
+std::string getLabel(const Node& node) {
+    std::string label = node.isARG ? getARGName(node.id) : getMGENameForLabel(node.id);
+    return label;
 }
 
-static std::string getTimepointCategory(const Timepoint& tp) {
-    int timeValue = static_cast<int>(tp);
-    if (timeValue == 1000) return "donor";
-    if (timeValue == 0)    return "pre";
-    if (timeValue > 0 && timeValue < 31) return "post1";
-    if (timeValue > 30 && timeValue < 61) return "post2";
-    if (timeValue > 60)    return "post3";
-    return "unknown"; // Fallback for any unexpected values
-}
 
+namespace {
+
+enum class GraphView { Interaction, Parent };
 
-auto timepointOrder = [](Timepoint tp) -> int {
-    if (tp == Timepoint::Donor) return -1;
-    if (tp == Timepoint::PreFMT) return 0;
-    return static_cast<int>(tp);
+// One link/node of a viz view; the view builders fill them in and either schema writes them
+struct ViewLink {
+    std::string source;
+    std::string target;
+    std::string style;
+    std::string color;
+    std::string type;
+    double penwidth = 4.0;
+    bool isColo = false;
+    int individualCount = 0;            // interaction view
+    std::set<std::string> diseases;     // interaction view
 };
 
-std::string getLabel(const Node& node) {
-    std::string label = node.isARG ? getARGName(node.id) : getMGENameForLabel(node.id);
-    return label;
+struct ViewNode {
+    std::string id;
+    std::string label;
+    std::string color;
+    std::string shape;
+    std::string mgeGroup;
+    std::string timepointCategory;
+    int timepoint = 0;
+    bool isARG = false;                          // interaction view
+    int community = -1;                          // interaction view, -1 when detection was not run
+    int argId = 0;                               // parent view
+    int mgeId = 0;                               // parent view
+    std::map<std::string, int> diseaseCounts;    // parent view; its keys are the node's diseases
+    bool hasPosition = false;                    // precomputed layout
+    double x = 0.0;
+    double y = 0.0;
+};
+
+using LinkSink = std::function<void(const ViewLink&)>;
+using NodeSink = std::function<void(const ViewNode&)>;
+// Builders report every link before the first node, the order both documents are written in
+using ViewBuilder = std::function<void(const LinkSink&, const NodeSink&)>;
+
+
+std::string temporalLinkColor(Timepoint src_tp, Timepoint tgt_tp) {
+    bool tgt_is_post = (tgt_tp != Timepoint::Donor && tgt_tp != Timepoint::PreFMT);
+    if (src_tp == Timepoint::Donor && tgt_tp == Timepoint::PreFMT)      return "#006400";
+    else if (src_tp == Timepoint::Donor && tgt_is_post)                 return "#4B0082";
+    else if (src_tp == Timepoint::PreFMT && tgt_is_post)                return "orange";
+    else                                                                return "black";
 }
 
 
-bool exportGraphToJsonSimple(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap) {
-    json j;
-    j["nodes"] = json::array();
-    j["links"] = json::array();
+// How interaction-view nodes are named: entities by default, hierarchy groups for a coarse graph
+struct NodeNaming {
+    std::function<std::string(const Node&)> id = [](const Node& n) { return getNodeName(n); };
+    std::function<std::string(const Node&)> label = getLabel;
+    std::function<std::string(const Node&)> mgeGroup = [](const Node& n) { return getMGEGroupName(n.id); };
+};
+
+
+NodeNaming coarseNaming(const CoarseGraph& coarse) {
+    NodeNaming naming;
+    const bool argRolled = coarse.spec.arg != ARGRollup::None;
+    const bool mgeRolled = coarse.spec.mge != MGERollup::None;
+    auto rolled = [=](const Node& n) { return n.isARG ? argRolled : mgeRolled; };
 
+    // "G_" keeps group ids apart from the entity ids of a side that was not rolled up
+    naming.id = [=](const Node& n) {
+        if (!rolled(n)) return getNodeName(n);
+        return "G_" + std::to_string(n.id) + (n.isARG ? "_ARG_" : "_MGE_") + std::to_string(static_cast<int>(n.timepoint));
+    };
+    naming.label = [=, &coarse](const Node& n) {
+        if (!rolled(n)) return getLabel(n);
+        return (n.isARG ? coarse.argLabels : coarse.mgeLabels).at(static_cast<size_t>(n.id));
+    };
+    naming.mgeGroup = [=, &coarse](const Node& n) {
+        return mgeRolled ? coarse.mgeLabels.at(static_cast<size_t>(n.id)) : getMGEGroupName(n.id);
+    };
+    return naming;
+}
+
+
+void buildInteractionView(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap, const CommunityMap& communities,
+                          const LinkSink& onLink, const NodeSink& onNode, const NodeNaming& naming = NodeNaming()) {
     std::unordered_set<Node> active_nodes;
     std::set<std::pair<Node, Node>> processedColoEdges;
 
@@ -64,106 +124,67 @@ bool exportGraphToJsonSimple(const Graph& g, const std::string& outPathStr, cons
 
         active_nodes.insert(edge.source);
         active_nodes.insert(edge.target);
-        
-        std::string style;
-        std::string color;
-        double penwidth = 4.0;
-        std::string type = "other";
-        json diseases = json::array();
+
+        ViewLink link;
+        link.type = "other";
         if (edge.isColo) {
             auto canon = std::minmax(edge.source, edge.target);
             if (processedColoEdges.count(canon)) continue;
             processedColoEdges.insert(canon);
-            style = "solid";
-            color = "#696969";
-            type  = "colocalization";
-            std::set<std::string> diseaseSet; 
+            link.style = "solid";
+            link.color = "#696969";
+            link.type  = "colocalization";
             for (int patientID : edge.individuals) {
                 auto it = patientToDiseaseMap.find(patientID);
                 if (it != patientToDiseaseMap.end()) {
-                    diseaseSet.insert(it->second); 
+                    link.diseases.insert(it->second);
                 }
             }
-            for (const auto& diseaseName : diseaseSet) {
-                diseases.push_back(diseaseName);
-            }
             int count = static_cast<int>(edge.individuals.size());
-            if (count > 1) penwidth = 4.0 + (count - 1) * 2.0;
-            penwidth = std::min(10.0, penwidth);
+            if (count > 1) link.penwidth = 4.0 + (count - 1) * 2.0;
+            link.penwidth = std::min(10.0, link.penwidth);
         } 
-        else if (!edge.isColo) {
-            style = "dashed";
-            type  = "temporal";
+        else {
+            link.style = "dashed";
+            link.type  = "temporal";
             int w = edge.weight;
-            if (w > 1) penwidth = 4.0 + (w - 1) * 2.0;
-            penwidth = std::min(10.0, penwidth);
-            Timepoint src_tp = edge.source.timepoint;
-            Timepoint tgt_tp = edge.target.timepoint;
-            bool tgt_is_post = (tgt_tp != Timepoint::Donor && tgt_tp != Timepoint::PreFMT);
-            if (src_tp == Timepoint::Donor && tgt_tp == Timepoint::PreFMT)      color = "#006400";
-            else if (src_tp == Timepoint::Donor && tgt_is_post)                 color = "#4B0082";
-            else if (src_tp == Timepoint::PreFMT && tgt_is_post)                color = "orange";
-            else                                                                color = "black";
+            if (w > 1) link.penwidth = 4.0 + (w - 1) * 2.0;
+            link.penwidth = std::min(10.0, link.penwidth);
+            link.color = temporalLinkColor(edge.source.timepoint, edge.target.timepoint);
         } 
-        else {
-            style = "solid";
-            color = "#808080";
-        }
-        j["links"].push_back({
-            {"source", getNodeName(edge.source)},
-            {"target", getNodeName(edge.target)},
-            {"individualCount", static_cast<int>(edge.individuals.size())},
-            {"style", style},
-            {"color", color},
-            {"penwidth", penwidth},
-            {"isColo", edge.isColo},
-            {"type", type},
-            {"diseases", diseases}
-        });
+        link.source = naming.id(edge.source);
+        link.target = naming.id(edge.target);
+        link.individualCount = static_cast<int>(edge.individuals.size());
+        link.isColo = edge.isColo;
+        onLink(link);
     }
 
     for (const Node& n : active_nodes) {
-        std::string shape;
-        std::string mgeGroup = ""; 
-
+        ViewNode node;
         if (n.isARG) {
-            shape = "circle";
+            node.shape = "circle";
         } else {
-            mgeGroup = getMGEGroupName(n.id);
-            shape = getMGEGroupShape(mgeGroup);
+            node.mgeGroup = naming.mgeGroup(n);
+            node.shape = getMGEGroupShape(node.mgeGroup);
         }
-
-        j["nodes"].push_back({
-            {"id",                getNodeName(n)},
-            {"label",             getLabel(n)},
-            {"isARG",             n.isARG},
-            {"timepoint",         static_cast<int>(n.timepoint)},
-            {"color",             getTimepointColor(n.timepoint)},
-            {"shape",             shape},
-            {"mgeGroup",          mgeGroup},
-            {"timepointCategory", getTimepointCategory(n.timepoint)}
-        });
-    }
-
-    std::ofstream out(outPathStr);
-    if (!out) {
-        std::cerr << "[exportGraphToJsonSimple] Cannot open " << outPathStr << " for write\n";
-        return false;
+        node.id                = naming.id(n);
+        node.label             = naming.label(n);
+        node.isARG             = n.isARG;
+        node.timepoint         = static_cast<int>(n.timepoint);
+        node.color             = activePostWindows().color(n.timepoint);
+        node.timepointCategory = activePostWindows().categoryName(n.timepoint);
+
+        // Community of the entity (shared by all its timepoint nodes), if detection was run
+        auto community = communities.find({n.id, n.isARG});
+        if (community != communities.end()) node.community = community->second;
+
+        onNode(node);
     }
-    out << j.dump(2) << '\n';
-
-    std::cerr << "[exportGraphToJsonSimple] Wrote nodes=" << j["nodes"].size()
-              << " links=" << j["links"].size()
-              << " to " << outPathStr << "\n";
-    return true;
 }
 
 
-bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap, bool showLabels) {
-    json j;
-    j["nodes"] = json::array();
-    j["links"] = json::array();
-
+void buildParentView(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap, bool showLabels,
+                     const LinkSink& onLink, const NodeSink& onNode) {
     struct ParentNodeInfo {
         std::string name;
         Timepoint tp;
@@ -174,6 +195,8 @@ bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, cons
     int colocCounter = 0;
     std::map<std::tuple<int,int,Timepoint>, std::string> uniqueParents;
     std::map<std::pair<int,int>, std::vector<ParentNodeInfo>> colocMap;
+    // Edge that introduced each parent node, in numbering order; its fields are reported after the links
+    std::vector<const Edge*> parentEdges;
 
     for (const Edge& edge : g.edges) {
         if (!edge.isColo) continue;
@@ -187,104 +210,536 @@ bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, cons
 
         auto key = std::make_tuple(argId, mgeId, tp);
         if (!uniqueParents.count(key)) {
-            std::string parentName = "Parent_" + std::to_string(++colocCounter);
-            uniqueParents[key] = parentName;
-
-            std::string color = getTimepointColor(tp);
-            std::string groupName = getMGEGroupName(mgeId);
-            std::string shape = getMGEGroupShape(groupName);
-            std::string label = showLabels ? (getARGName(argId) + "+" + getMGENameForLabel(mgeId)) : "";
-            
-            std::set<std::string> diseaseSet;
-            std::map<std::string, std::set<int>> diseaseToIndividualsLocal; // local per colocalization
-
-            // collect diseases + individuals for this edge only
-            for (int patientID : edge.individuals) {
-                auto it = patientToDiseaseMap.find(patientID);
-                if (it != patientToDiseaseMap.end()) {
-                    diseaseSet.insert(it->second);
-                    diseaseToIndividualsLocal[it->second].insert(patientID);
-                }
-            }
-
-            // convert diseases list
-            json diseases = json::array();
-            for (const auto& diseaseName : diseaseSet) {
-                diseases.push_back(diseaseName);
-            }
-
-            // convert to JSON: disease → patient count (for this colocalization/timepoint)
-            json diseaseCounts = json::object();
-            for (const auto& [diseaseName, individuals] : diseaseToIndividualsLocal) {
-                diseaseCounts[diseaseName] = static_cast<int>(individuals.size());
-            }
-
-
-            j["nodes"].push_back({
-                {"id",                parentName},
-                {"label",             label},
-                {"argId",             argId},
-                {"mgeId",             mgeId},
-                {"timepoint",         static_cast<int>(tp)},
-                {"color",             color},
-                {"shape",             shape},
-                {"diseases",          diseases},
-                {"diseaseCounts",     diseaseCounts},
-                {"mgeGroup",          groupName}, 
-                {"timepointCategory", getTimepointCategory(tp)}
-            });
+            uniqueParents[key] = "Parent_" + std::to_string(++colocCounter);
+            parentEdges.push_back(&edge);
         }
 
         auto pairKey = std::make_pair(argId, mgeId);
         colocMap[pairKey].push_back({uniqueParents[key], tp, argId, mgeId});
     }
 
-    // ... (The temporal link-processing loop remains unchanged) ...
+    ViewLink link;
+    link.style = "dashed";
+    link.penwidth = 5.0;
+    link.type = "temporal";
     for (auto& entry : colocMap) {
         auto& parentNodes = entry.second;
         std::sort(parentNodes.begin(), parentNodes.end(),
             [&](const ParentNodeInfo& a, const ParentNodeInfo& b) {
-                return timepointOrder(a.tp) < timepointOrder(b.tp);
+                return ordinalOf(a.tp) < ordinalOf(b.tp);
             });
 
         for (size_t i = 0; i + 1 < parentNodes.size(); ++i) {
             if (parentNodes[i].tp == parentNodes[i+1].tp || parentNodes[i].name == parentNodes[i+1].name) {
                 continue;
             }
-            Timepoint src_tp = parentNodes[i].tp;
-            Timepoint tgt_tp = parentNodes[i+1].tp;
-            bool tgt_is_post = (tgt_tp != Timepoint::Donor && tgt_tp != Timepoint::PreFMT);
-            std::string color;
-            if (src_tp == Timepoint::Donor && tgt_tp == Timepoint::PreFMT)      color = "#006400";
-            else if (src_tp == Timepoint::Donor && tgt_is_post)                 color = "#4B0082";
-            else if (src_tp == Timepoint::PreFMT && tgt_is_post)                color = "orange";
-            else                                                                color = "black";
-
-            j["links"].push_back({
-                {"source", parentNodes[i].name},
-                {"target", parentNodes[i+1].name},
-                {"style", "dashed"},
-                {"color", color},
-                {"penwidth", 5.0},
-                {"isColo", false},
-                {"type", "temporal"}
+            link.source = parentNodes[i].name;
+            link.target = parentNodes[i+1].name;
+            link.color = temporalLinkColor(parentNodes[i].tp, parentNodes[i+1].tp);
+            onLink(link);
+        }
+    }
+
+    for (size_t p = 0; p < parentEdges.size(); ++p) {
+        const Edge& edge = *parentEdges[p];
+        const Node& argNode = edge.source.isARG ? edge.source : edge.target;
+        const Node& mgeNode = edge.source.isARG ? edge.target : edge.source;
+        const Timepoint tp = argNode.timepoint;
+
+        ViewNode node;
+        node.id                = "Parent_" + std::to_string(p + 1);
+        node.label             = showLabels ? (getARGName(argNode.id) + "+" + getMGENameForLabel(mgeNode.id)) : "";
+        node.argId             = argNode.id;
+        node.mgeId             = mgeNode.id;
+        node.timepoint         = static_cast<int>(tp);
+        node.color             = activePostWindows().color(tp);
+        node.mgeGroup          = getMGEGroupName(mgeNode.id);
+        node.shape             = getMGEGroupShape(node.mgeGroup);
+        node.timepointCategory = activePostWindows().categoryName(tp);
+
+        // diseases + individuals of the edge that introduced this colocalization/timepoint
+        std::map<std::string, std::set<int>> diseaseToIndividualsLocal;
+        for (int patientID : edge.individuals) {
+            auto it = patientToDiseaseMap.find(patientID);
+            if (it != patientToDiseaseMap.end()) {
+                diseaseToIndividualsLocal[it->second].insert(patientID);
+            }
+        }
+        for (const auto& [diseaseName, individuals] : diseaseToIndividualsLocal)
+            node.diseaseCounts[diseaseName] = static_cast<int>(individuals.size());
+
+        onNode(node);
+    }
+}
+
+
+/* Record schema: {"links": [{...}], "nodes": [{...}]}, keys in the sorted order nlohmann dumped them in */
+// Categories of the active post-FMT scheme with their labels and colours, for the viz's stage filter
+void writeTimepointCategories(JsonWriter& out) {
+    out.key("timepointCategories").beginArray();
+    for (const TimepointCategoryInfo& category : activePostWindows().categories()) {
+        out.beginObject()
+           .field("color", category.color)
+           .field("label", category.label)
+           .field("name",  category.name)
+           .endObject();
+    }
+    out.endArray();
+}
+
+
+JsonGraphCounts writeRecords(JsonWriter& out, GraphView view, const ViewBuilder& build) {
+    JsonGraphCounts counts;
+    out.beginObject().key("links").beginArray();
+
+    auto onLink = [&](const ViewLink& link) {
+        out.beginObject().field("color", link.color);
+        if (view == GraphView::Interaction) {
+            out.key("diseases").beginArray();
+            for (const auto& diseaseName : link.diseases) out.value(diseaseName);
+            out.endArray().field("individualCount", link.individualCount);
+        }
+        out.field("isColo",   link.isColo)
+           .field("penwidth", link.penwidth)
+           .field("source",   link.source)
+           .field("style",    link.style)
+           .field("target",   link.target)
+           .field("type",     link.type)
+           .endObject();
+        ++counts.links;
+    };
+
+    auto onNode = [&](const ViewNode& node) {
+        if (counts.nodes++ == 0) out.endArray().key("nodes").beginArray();
+        out.beginObject();
+        if (view == GraphView::Interaction) {
+            out.field("color", node.color);
+            if (node.community >= 0) out.field("community", node.community);
+            out.field("id",    node.id)
+               .field("isARG", node.isARG)
+               .field("label", node.label);
+        } else {
+            out.field("argId", node.argId)
+               .field("color", node.color);
+            out.key("diseaseCounts").beginObject();
+            for (const auto& [diseaseName, count] : node.diseaseCounts) out.field(diseaseName, count);
+            out.endObject();
+            out.key("diseases").beginArray();
+            for (const auto& entry : node.diseaseCounts) out.value(entry.first);
+            out.endArray();
+            out.field("id",    node.id)
+               .field("label", node.label);
+        }
+        out.field("mgeGroup", node.mgeGroup);
+        if (view == GraphView::Parent) out.field("mgeId", node.mgeId);
+        out.field("shape",             node.shape)
+           .field("timepoint",         node.timepoint)
+           .field("timepointCategory", node.timepointCategory);
+        if (node.hasPosition) out.field("x", node.x).field("y", node.y);
+        out.endObject();
+    };
+
+    build(onLink, onNode);
+    if (counts.nodes == 0) out.endArray().key("nodes").beginArray();
+    out.endArray();
+    writeTimepointCategories(out);
+    out.endObject();
+    return counts;
+}
+
+
+// Lookup table of a columnar document: each distinct string gets the next index
+struct StringTable {
+    std::unordered_map<std::string, int> index;
+    std::vector<std::string> values;
+
+    int code(const std::string& value) {
+        auto [it, inserted] = index.emplace(value, static_cast<int>(values.size()));
+        if (inserted) values.push_back(value);
+        return it->second;
+    }
+};
+
+
+template <typename Rows, typename WriteValue>
+void writeColumn(JsonWriter& out, const char* name, const Rows& rows, WriteValue writeValue) {
+    out.key(name).beginArray();
+    for (const auto& row : rows) writeValue(row);
+    out.endArray();
+}
+
+
+/* Columnar schema (see export_graph_json.h); rows are collected first since links refer to node rows */
+JsonGraphCounts writeColumnar(JsonWriter& out, GraphView view, const ViewBuilder& build) {
+    std::vector<ViewLink> links;
+    std::vector<ViewNode> nodes;
+    build([&](const ViewLink& link) { links.push_back(link); },
+          [&](const ViewNode& node) { nodes.push_back(node); });
+
+    std::unordered_map<std::string, int> nodeRow;
+    bool anyCommunity = false, anyPosition = false;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodeRow.emplace(nodes[i].id, static_cast<int>(i));
+        anyCommunity = anyCommunity || nodes[i].community >= 0;
+        anyPosition = anyPosition || nodes[i].hasPosition;
+    }
+
+    std::map<std::string, StringTable> tables;
+    auto coded = [&](const char* name) {
+        return [&out, &table = tables[name]](const std::string& value) { out.value(table.code(value)); };
+    };
+    auto flag = [&](bool value) { out.value(value ? 1 : 0); };
+    auto number = [&](auto value) { out.value(value); };
+
+    out.beginObject().field("format", GRAPH_JSON_COLUMNAR_FORMAT);
+
+    out.key("links").beginObject();
+    {
+        const auto color = coded("color");
+        writeColumn(out, "color", links, [&](const ViewLink& l) { color(l.color); });
+        if (view == GraphView::Interaction) {
+            auto& diseases = tables["disease"];
+            writeColumn(out, "diseases", links, [&](const ViewLink& l) {
+                out.beginArray();
+                for (const auto& diseaseName : l.diseases) out.value(diseases.code(diseaseName));
+                out.endArray();
             });
+            writeColumn(out, "individualCount", links, [&](const ViewLink& l) { number(l.individualCount); });
         }
+        writeColumn(out, "isColo", links, [&](const ViewLink& l) { flag(l.isColo); });
+        writeColumn(out, "penwidth", links, [&](const ViewLink& l) { number(l.penwidth); });
+        // Shards keep links to nodes stored in another shard; those endpoints stay ids
+        auto endpoint = [&](const std::string& id) {
+            auto row = nodeRow.find(id);
+            if (row != nodeRow.end()) out.value(row->second);
+            else out.value(id);
+        };
+        writeColumn(out, "source", links, [&](const ViewLink& l) { endpoint(l.source); });
+        const auto style = coded("style");
+        writeColumn(out, "style", links, [&](const ViewLink& l) { style(l.style); });
+        writeColumn(out, "target", links, [&](const ViewLink& l) { endpoint(l.target); });
+        const auto type = coded("type");
+        writeColumn(out, "type", links, [&](const ViewLink& l) { type(l.type); });
     }
+    out.endObject();
+
+    out.key("nodes").beginObject();
+    {
+        if (view == GraphView::Parent)
+            writeColumn(out, "argId", nodes, [&](const ViewNode& n) { number(n.argId); });
+        const auto color = coded("color");
+        writeColumn(out, "color", nodes, [&](const ViewNode& n) { color(n.color); });
+        if (anyCommunity)
+            writeColumn(out, "community", nodes, [&](const ViewNode& n) { number(n.community); });
+        if (view == GraphView::Parent) {
+            auto& diseases = tables["disease"];
+            writeColumn(out, "diseaseCounts", nodes, [&](const ViewNode& n) {
+                out.beginArray();
+                for (const auto& [diseaseName, count] : n.diseaseCounts) out.value(diseases.code(diseaseName)).value(count);
+                out.endArray();
+            });
+        }
+        writeColumn(out, "id", nodes, [&](const ViewNode& n) { out.value(n.id); });
+        if (view == GraphView::Interaction)
+            writeColumn(out, "isARG", nodes, [&](const ViewNode& n) { flag(n.isARG); });
+        writeColumn(out, "label", nodes, [&](const ViewNode& n) { out.value(n.label); });
+        const auto mgeGroup = coded("mgeGroup");
+        writeColumn(out, "mgeGroup", nodes, [&](const ViewNode& n) { mgeGroup(n.mgeGroup); });
+        if (view == GraphView::Parent)
+            writeColumn(out, "mgeId", nodes, [&](const ViewNode& n) { number(n.mgeId); });
+        const auto shape = coded("shape");
+        writeColumn(out, "shape", nodes, [&](const ViewNode& n) { shape(n.shape); });
+        writeColumn(out, "timepoint", nodes, [&](const ViewNode& n) { number(n.timepoint); });
+        const auto category = coded("timepointCategory");
+        writeColumn(out, "timepointCategory", nodes, [&](const ViewNode& n) { category(n.timepointCategory); });
+        if (anyPosition) {
+            writeColumn(out, "x", nodes, [&](const ViewNode& n) { number(n.x); });
+            writeColumn(out, "y", nodes, [&](const ViewNode& n) { number(n.y); });
+        }
+    }
+    out.endObject();
+    writeTimepointCategories(out);
+
+    out.key("tables").beginObject();
+    for (const auto& [name, table] : tables) {
+        out.key(name).beginArray();
+        for (const auto& value : table.values) out.value(value);
+        out.endArray();
+    }
+    out.endObject().endObject();
+
+    return {nodes.size(), links.size()};
+}
+
+
+// Link rest lengths of graph.js's simulation; positions are rounded to 0.1 px to keep the files small
+void layoutView(std::vector<ViewNode>& nodes, const std::vector<ViewLink>& links, const LayoutOptions& options) {
+    std::unordered_map<std::string, size_t> nodeIndex;
+    for (size_t i = 0; i < nodes.size(); ++i) nodeIndex.emplace(nodes[i].id, i);
+
+    std::vector<LayoutEdge> edges;
+    edges.reserve(links.size());
+    for (const ViewLink& link : links)
+        edges.push_back({nodeIndex.at(link.source), nodeIndex.at(link.target), link.isColo ? 40.0 : 60.0});
+
+    const std::vector<LayoutPoint> points = forceDirectedLayout(nodes.size(), edges, options);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].hasPosition = true;
+        nodes[i].x = std::round(points[i].x * 10) / 10;
+        nodes[i].y = std::round(points[i].y * 10) / 10;
+    }
+}
+
+
+// The view with positions: rows are collected, laid out, then replayed in their original order
+ViewBuilder laidOut(const ViewBuilder& build, const LayoutOptions& options) {
+    return [&build, &options](const LinkSink& onLink, const NodeSink& onNode) {
+        std::vector<ViewLink> links;
+        std::vector<ViewNode> nodes;
+        build([&](const ViewLink& link) { links.push_back(link); },
+              [&](const ViewNode& node) { nodes.push_back(node); });
+        layoutView(nodes, links, options);
+        for (const ViewLink& link : links) onLink(link);
+        for (const ViewNode& node : nodes) onNode(node);
+    };
+}
+
+
+// Rows of one shard, as indices into the collected view
+struct ViewShard {
+    std::string file;    // relative to the shard directory
+    std::vector<size_t> nodes;
+    std::vector<size_t> links;
+};
+
+
+// Label with the characters file systems reject replaced by '_'
+std::string shardFileName(std::string name) {
+    for (char& c : name)
+        if (std::strchr("/\\:*?\"<>|", c) && c != '\0') c = '_';
+    return name;
+}
+
+
+// Every row of a view, collected (and laid out) once so several documents can be written from it
+struct CollectedView {
+    std::vector<ViewLink> links;
+    std::vector<ViewNode> nodes;
+};
 
-    std::ofstream out(outPathStr);
-    if (!out) {
-        std::cerr << "[exportParentGraphToJson] Cannot open " << outPathStr << " for write\n";
+
+CollectedView collectParentView(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap, bool showLabels,
+                                const GraphJsonOptions& options) {
+    CollectedView view;
+    buildParentView(g, patientToDiseaseMap, showLabels,
+                    [&](const ViewLink& link) { view.links.push_back(link); },
+                    [&](const ViewNode& node) { view.nodes.push_back(node); });
+    if (options.layout) layoutView(view.nodes, view.links, options.layoutOptions);
+    return view;
+}
+
+
+ViewBuilder replay(const CollectedView& view) {
+    return [&view](const LinkSink& onLink, const NodeSink& onNode) {
+        for (const ViewLink& link : view.links) onLink(link);
+        for (const ViewNode& node : view.nodes) onNode(node);
+    };
+}
+
+
+// Writes one view to a file in the configured schema; false (with the reason on stderr) when the file cannot be written
+bool exportView(const char* caller, const char* nodeNoun, const std::string& outPathStr, GraphView view,
+                const GraphJsonOptions& options, const ViewBuilder& build) {
+    JsonGraphCounts counts;
+    try {
+        const ViewBuilder rows = options.layout ? laidOut(build, options.layoutOptions) : build;
+        JsonWriter out(outPathStr, options.compact || options.columnar ? -1 : 2);
+        counts = options.columnar ? writeColumnar(out, view, rows) : writeRecords(out, view, rows);
+        out.close();
+    } catch (const std::runtime_error& e) {
+        std::cerr << "[" << caller << "] " << e.what() << "\n";
         return false;
     }
-    out << j.dump(2) << '\n';
 
-    std::cerr << "[exportParentGraphToJson] Wrote parent-nodes=" << j["nodes"].size()
-              << " links=" << j["links"].size()
+    std::cerr << "[" << caller << "] Wrote " << nodeNoun << "=" << counts.nodes
+              << " links=" << counts.links
               << " to " << outPathStr << "\n";
     return true;
 }
 
+// Every shard is a row subset of the same collected view
+bool writeParentShards(const CollectedView& view, const std::string& shardDir, const GraphJsonOptions& options) {
+    const std::vector<ViewLink>& links = view.links;
+    const std::vector<ViewNode>& nodes = view.nodes;
+
+    // shard lookups: all diseases x category, disease x category, MGE group (several groups may share a file)
+    std::map<std::string, std::map<std::string, size_t>> byDisease;
+    std::map<std::string, size_t> allByCategory, byGroup;
+    std::map<std::string, size_t> shardOfFile;
+    std::vector<ViewShard> shards;
+    auto shardFor = [&](const std::string& file) {
+        auto [it, inserted] = shardOfFile.emplace(file, shards.size());
+        if (inserted) shards.push_back({file, {}, {}});
+        return it->second;
+    };
+
+    // A handful of distinct categories, groups and diseases name every file
+    std::unordered_map<std::string, std::string> fileNames;
+    auto fileName = [&](const std::string& label) -> const std::string& {
+        auto it = fileNames.find(label);
+        if (it == fileNames.end()) it = fileNames.emplace(label, shardFileName(label)).first;
+        return it->second;
+    };
+
+    std::unordered_map<std::string, size_t> nodeIndex;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const ViewNode& node = nodes[i];
+        nodeIndex.emplace(node.id, i);
+        const std::string& category = fileName(node.timepointCategory);
+
+        const size_t all = shardFor("all/" + category + ".json");
+        allByCategory[node.timepointCategory] = all;
+        shards[all].nodes.push_back(i);
+
+        const size_t group = shardFor("by_mge_group/" + fileName(node.mgeGroup) + ".json");
+        byGroup[node.mgeGroup] = group;
+        shards[group].nodes.push_back(i);
+
+        for (const auto& entry : node.diseaseCounts) {
+            const size_t disease = shardFor("by_disease/" + fileName(entry.first) + "/" + category + ".json");
+            byDisease[entry.first][node.timepointCategory] = disease;
+            shards[disease].nodes.push_back(i);
+        }
+    }
+
+    // A link lives with its source node; a client that loads the target's shard too gets both ends
+    for (size_t l = 0; l < links.size(); ++l) {
+        const ViewNode& source = nodes[nodeIndex.at(links[l].source)];
+        const ViewNode& target = nodes[nodeIndex.at(links[l].target)];
+        shards[allByCategory.at(source.timepointCategory)].links.push_back(l);
+        shards[byGroup.at(source.mgeGroup)].links.push_back(l);
+        for (const auto& entry : source.diseaseCounts) {
+            if (target.diseaseCounts.count(entry.first))
+                shards[byDisease.at(entry.first).at(source.timepointCategory)].links.push_back(l);
+        }
+    }
+
+    const fs::path root(shardDir);
+    try {
+        // Shards of diseases/groups no longer in the data must not linger next to the new manifest
+        for (const char* sub : {"all", "by_disease", "by_mge_group"}) fs::remove_all(root / sub);
+        for (const ViewShard& shard : shards) fs::create_directories((root / shard.file).parent_path());
+    } catch (const fs::filesystem_error& e) {
+        std::cerr << "[exportParentGraphShards] " << e.what() << "\n";
+        return false;
+    }
+
+    std::vector<char> written(shards.size(), 0);
+    parallelFor(shards.size(), [&](size_t s) {
+        const ViewShard& shard = shards[s];
+        const auto rows = [&](const LinkSink& onLink, const NodeSink& onNode) {
+            for (size_t l : shard.links) onLink(links[l]);
+            for (size_t n : shard.nodes) onNode(nodes[n]);
+        };
+        try {
+            JsonWriter out((root / shard.file).string(), options.compact || options.columnar ? -1 : 2);
+            if (options.columnar) writeColumnar(out, GraphView::Parent, rows);
+            else writeRecords(out, GraphView::Parent, rows);
+            out.close();
+            written[s] = 1;
+        } catch (const std::runtime_error& e) {
+            std::cerr << "[exportParentGraphShards] " + std::string(e.what()) + "\n";
+        }
+    });
+    if (std::count(written.begin(), written.end(), 0)) return false;
+
+    // Manifest: which file holds which slice, paths relative to it
+    try {
+        JsonWriter manifest((root / "manifest.json").string(), options.compact ? -1 : 2);
+        manifest.beginObject().key("all").beginObject();
+        for (const auto& [category, shard] : allByCategory) manifest.field(category, shards[shard].file);
+        manifest.endObject().key("diseases").beginObject();
+        for (const auto& [disease, categories] : byDisease) {
+            manifest.key(disease).beginObject();
+            for (const auto& [category, shard] : categories) manifest.field(category, shards[shard].file);
+            manifest.endObject();
+        }
+        manifest.endObject().key("mgeGroups").beginObject();
+        for (const auto& [group, shard] : byGroup) manifest.field(group, shards[shard].file);
+        manifest.endObject();
+        writeTimepointCategories(manifest);
+        manifest.endObject();
+        manifest.close();
+    } catch (const std::runtime_error& e) {
+        std::cerr << "[exportParentGraphShards] " << e.what() << "\n";
+        return false;
+    }
+
+    std::cerr << "[exportParentGraphShards] Wrote " << shards.size() << " shards of parent-nodes=" << nodes.size()
+              << " links=" << links.size() << " to " << shardDir << "\n";
+    return true;
+}
+
+} // namespace
+
+
+JsonGraphCounts writeGraphJsonSimple(JsonWriter& out, const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                                     const CommunityMap& communities) {
+    return writeRecords(out, GraphView::Interaction, [&](const LinkSink& onLink, const NodeSink& onNode) {
+        buildInteractionView(g, patientToDiseaseMap, communities, onLink, onNode);
+    });
+}
+
+
+bool exportGraphToJsonSimple(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             const CommunityMap& communities, const GraphJsonOptions& options) {
+    return exportView("exportGraphToJsonSimple", "nodes", outPathStr, GraphView::Interaction, options,
+        [&](const LinkSink& onLink, const NodeSink& onNode) {
+            buildInteractionView(g, patientToDiseaseMap, communities, onLink, onNode);
+        });
+}
+
+
+bool exportCoarseGraphToJson(const CoarseGraph& coarse, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             const GraphJsonOptions& options) {
+    const NodeNaming naming = coarseNaming(coarse);
+    return exportView("exportCoarseGraphToJson", "group-nodes", outPathStr, GraphView::Interaction, options,
+        [&](const LinkSink& onLink, const NodeSink& onNode) {
+            buildInteractionView(coarse.graph, patientToDiseaseMap, {}, onLink, onNode, naming);
+        });
+}
+
+
+bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, const std::map<int, std::string>& patientToDiseaseMap,
+                             bool showLabels, const GraphJsonOptions& options) {
+    return exportView("exportParentGraphToJson", "parent-nodes", outPathStr, GraphView::Parent, options,
+        [&](const LinkSink& onLink, const NodeSink& onNode) {
+            buildParentView(g, patientToDiseaseMap, showLabels, onLink, onNode);
+        });
+}
+
+
+bool exportParentGraphShards(const Graph& g, const std::string& shardDir, const std::map<int, std::string>& patientToDiseaseMap,
+                             bool showLabels, const GraphJsonOptions& options) {
+    return writeParentShards(collectParentView(g, patientToDiseaseMap, showLabels, options), shardDir, options);
+}
+
+
+bool exportParentGraphWithShards(const Graph& g, const std::string& outPathStr, const std::string& shardDir,
+                                 const std::map<int, std::string>& patientToDiseaseMap, bool showLabels,
+                                 const GraphJsonOptions& options) {
+    const CollectedView view = collectParentView(g, patientToDiseaseMap, showLabels, options);
+    GraphJsonOptions laidOutAlready = options;
+    laidOutAlready.layout = false;
+    const bool wroteDocument = exportView("exportParentGraphToJson", "parent-nodes", outPathStr, GraphView::Parent,
+                                          laidOutAlready, replay(view));
+    const bool wroteShards = writeParentShards(view, shardDir, options);
+    return wroteDocument && wroteShards;
+}
+
+
+
+
 
 
 // void exportColocalizationsToJSONByDisease(
@@ -359,56 +814,10 @@ bool exportParentGraphToJson(const Graph& g, const std::string& outPathStr, cons
 void exportColocalizationsToJSONByDisease(
     const std::map<std::tuple<int,int,int>, std::set<Timepoint>>& colocalizationByIndividual,
     const std::map<int, std::string>& patientToDiseaseMap,
-    const std::string& jsonOutputPath  // path to the final JSON file
+    const std::string& jsonOutputPath,  // path to the final JSON file
+    bool compact
 ) {
-    std::map<std::string, std::map<std::string, std::map<std::string, int>>> diseaseColocCounts;
-
-    // Build counts by disease → colocalization → status
-    for (const auto& [tuple, tps] : colocalizationByIndividual) {
-        const int patientID = std::get<0>(tuple);
-        const int argID     = std::get<1>(tuple);
-        const int mgeID     = std::get<2>(tuple);
-        std::string disease = patientToDiseaseMap.at(patientID);
-
-        bool hasDonor = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp){ return isDonor(tp); });
-        bool hasPre   = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp){ return isPreFMT(tp); });
-        bool hasPost  = std::any_of(tps.begin(), tps.end(), [](const Timepoint& tp){ return isPostFMT(tp); });
-
-        std::string status;
-        if (hasPost && !hasPre && !hasDonor) status = "emerged";
-        else if (hasPre && !hasPost && !hasDonor) status = "disappeared";
-        else if (hasDonor && hasPost && !hasPre) status = "transferred";
-        else if (hasPre && hasPost) status = "persisted";
-        else continue; // skip other patterns
-
-        std::string pairName = getARGName(argID) + "–" + getMGEName(mgeID);
-        diseaseColocCounts[disease][pairName][status]++;
-    }
-
-    // Build JSON structure
-    json rootJson = json::object();  // use object instead of array
-
-    for (const auto& [disease, colocMap] : diseaseColocCounts) {
-        json diseaseArray = json::array();
-
-        for (const auto& [pair, statusMap] : colocMap) {
-            for (const auto& [status, count] : statusMap) {
-                diseaseArray.push_back({
-                    {"colocalization", pair},
-                    {"status", status},
-                    {"patients", count}
-                });
-            }
-        }
-
-        rootJson[disease] = diseaseArray;
-    }
-
-    std::filesystem::path outFile(jsonOutputPath);
-    std::ofstream all(outFile.string());  
-    if (!all.is_open()) {
-        throw std::runtime_error("Failed to open output JSON file: " + outFile.string());
-    }
-    all << std::setw(2) << rootJson << std::endl;
-    all.close();
+    // Counts by disease → colocalization → status, classified in one pass
+    DiseaseStatusJSONSink diseaseJson(patientToDiseaseMap, jsonOutputPath, compact);
+    classifyTemporalDynamics(colocalizationByIndividual, {&diseaseJson});
 }
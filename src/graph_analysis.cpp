@@ -0,0 +1,239 @@
+/* Centrality measures (degree, PageRank, sampled betweenness) on the colocalization network */
+#include "../include/graph_analysis.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include "../include/post_windows.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+CompactGraph buildColocalizationCSR(const Graph& g, const std::function<bool(Timepoint)>& includeTimepoint) {
+    // Distinct patients per (ARG, MGE) across the selected timepoints: a patient seen at several
+    // timepoints counts once
+    std::map<std::pair<int, int>, std::vector<int>> pairPatients;
+    for (const Edge& edge : g.edges) {
+        if (!edge.isColo || edge.individuals.empty()) continue;
+        if (includeTimepoint && !includeTimepoint(edge.source.timepoint)) continue;
+        int arg = edge.source.isARG ? edge.source.id : edge.target.id;
+        int mge = edge.source.isARG ? edge.target.id : edge.source.id;
+        auto& patients = pairPatients[{arg, mge}];
+        patients.insert(patients.end(), edge.individuals.begin(), edge.individuals.end());
+    }
+    std::map<std::pair<int, int>, double> pairWeights;
+    for (auto& [pair, patients] : pairPatients) {
+        std::sort(patients.begin(), patients.end());
+        pairWeights.emplace_hint(pairWeights.end(), pair,
+                                 static_cast<double>(std::unique(patients.begin(), patients.end()) - patients.begin()));
+    }
+
+    CompactGraph cg;
+    std::unordered_map<int, int> argIndex, mgeIndex;
+    auto vertexOf = [&](int id, bool isARG) {
+        auto& index = isARG ? argIndex : mgeIndex;
+        auto it = index.find(id);
+        if (it != index.end()) return it->second;
+        int v = static_cast<int>(cg.entityId.size());
+        index[id] = v;
+        cg.entityId.push_back(id);
+        cg.isARG.push_back(isARG);
+        return v;
+    };
+
+    std::vector<std::pair<int, int>> endpoints;
+    endpoints.reserve(pairWeights.size());
+    for (const auto& [pair, w] : pairWeights)
+        endpoints.emplace_back(vertexOf(pair.first, true), vertexOf(pair.second, false));
+
+    const size_t n = cg.entityId.size();
+    cg.offsets.assign(n + 1, 0);
+    for (const auto& [a, m] : endpoints) {
+        cg.offsets[a + 1]++;
+        cg.offsets[m + 1]++;
+    }
+    std::partial_sum(cg.offsets.begin(), cg.offsets.end(), cg.offsets.begin());
+
+    cg.neighbors.resize(cg.offsets[n]);
+    cg.weights.resize(cg.offsets[n]);
+    std::vector<size_t> fill(cg.offsets.begin(), cg.offsets.end() - 1);
+    size_t e = 0;
+    for (const auto& [pair, w] : pairWeights) {
+        auto [a, m] = endpoints[e++];
+        cg.neighbors[fill[a]] = m;  cg.weights[fill[a]++] = w;
+        cg.neighbors[fill[m]] = a;  cg.weights[fill[m]++] = w;
+    }
+    return cg;
+}
+
+
+// Weighted PageRank on the undirected network (pull formulation, parallel over vertices)
+std::vector<double> computePageRank(const CompactGraph& cg, double damping, int maxIterations, double tolerance) {
+    const size_t n = cg.vertexCount();
+    if (n == 0) return {};
+
+    std::vector<double> strength(n, 0.0);
+    for (size_t v = 0; v < n; ++v)
+        for (size_t i = cg.offsets[v]; i < cg.offsets[v + 1]; ++i) strength[v] += cg.weights[i];
+
+    std::vector<double> rank(n, 1.0 / n), next(n, 0.0);
+    const size_t workers = workerCount(n);
+    std::vector<double> partialDelta(workers);
+
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        double dangling = 0.0;
+        for (size_t v = 0; v < n; ++v)
+            if (strength[v] == 0.0) dangling += rank[v];
+        const double base = (1.0 - damping) / n + damping * dangling / n;
+
+        std::fill(partialDelta.begin(), partialDelta.end(), 0.0);
+        parallelForChunks(n, [&](size_t begin, size_t end, size_t t) {
+            double delta = 0.0;
+            for (size_t v = begin; v < end; ++v) {
+                double sum = 0.0;
+                for (size_t i = cg.offsets[v]; i < cg.offsets[v + 1]; ++i) {
+                    int u = cg.neighbors[i];
+                    sum += rank[u] * cg.weights[i] / strength[u];
+                }
+                next[v] = base + damping * sum;
+                delta += std::fabs(next[v] - rank[v]);
+            }
+            partialDelta[t] += delta;
+        }, workers);
+
+        rank.swap(next);
+        if (std::accumulate(partialDelta.begin(), partialDelta.end(), 0.0) < tolerance) break;
+    }
+    return rank;
+}
+
+
+// Brandes betweenness from a deterministic sample of BFS sources, parallel over sources
+std::vector<double> computeSampledBetweenness(const CompactGraph& cg, size_t samples, unsigned int seed) {
+    const size_t n = cg.vertexCount();
+    std::vector<double> result(n, 0.0);
+    if (n == 0) return result;
+
+    std::vector<int> sources(n);
+    std::iota(sources.begin(), sources.end(), 0);
+    if (samples < n) {
+        std::mt19937 rng(seed);
+        std::shuffle(sources.begin(), sources.end(), rng);
+        sources.resize(samples);
+    }
+
+    const size_t workers = workerCount(sources.size());
+    std::vector<std::vector<double>> partial(workers, std::vector<double>(n, 0.0));
+
+    parallelForChunks(sources.size(), [&](size_t begin, size_t end, size_t t) {
+        std::vector<int> dist(n), order;
+        std::vector<double> sigma(n), delta(n);
+        order.reserve(n);
+        for (size_t s = begin; s < end; ++s) {
+            const int src = sources[s];
+            std::fill(dist.begin(), dist.end(), -1);
+            std::fill(sigma.begin(), sigma.end(), 0.0);
+            std::fill(delta.begin(), delta.end(), 0.0);
+            order.clear();
+
+            dist[src] = 0;
+            sigma[src] = 1.0;
+            order.push_back(src);
+            for (size_t head = 0; head < order.size(); ++head) {
+                int v = order[head];
+                for (size_t i = cg.offsets[v]; i < cg.offsets[v + 1]; ++i) {
+                    int w = cg.neighbors[i];
+                    if (dist[w] < 0) {
+                        dist[w] = dist[v] + 1;
+                        order.push_back(w);
+                    }
+                    if (dist[w] == dist[v] + 1) sigma[w] += sigma[v];
+                }
+            }
+
+            // Dependency accumulation in reverse BFS order
+            for (size_t k = order.size(); k-- > 1;) {
+                int w = order[k];
+                for (size_t i = cg.offsets[w]; i < cg.offsets[w + 1]; ++i) {
+                    int v = cg.neighbors[i];
+                    if (dist[v] == dist[w] - 1) delta[v] += sigma[v] / sigma[w] * (1.0 + delta[w]);
+                }
+                partial[t][w] += delta[w];
+            }
+        }
+    }, workers, 1);
+
+    // Undirected paths are counted from both ends; rescale the sample to all sources
+    const double scale = static_cast<double>(n) / static_cast<double>(sources.size()) / 2.0;
+    for (const auto& p : partial)
+        for (size_t v = 0; v < n; ++v) result[v] += p[v];
+    for (double& b : result) b *= scale;
+    return result;
+}
+
+
+CentralityScores computeCentrality(const CompactGraph& cg, size_t betweennessSamples) {
+    const size_t n = cg.vertexCount();
+    CentralityScores scores;
+    scores.degree.resize(n);
+    scores.weightedDegree.resize(n);
+    parallelFor(n, [&](size_t v) {
+        scores.degree[v] = static_cast<int>(cg.offsets[v + 1] - cg.offsets[v]);
+        double s = 0.0;
+        for (size_t i = cg.offsets[v]; i < cg.offsets[v + 1]; ++i) s += cg.weights[i];
+        scores.weightedDegree[v] = s;
+    });
+    scores.pageRank = computePageRank(cg);
+    scores.betweenness = computeSampledBetweenness(cg, betweennessSamples);
+    return scores;
+}
+
+
+static void writeCentralityCSV(const CompactGraph& cg, const CentralityScores& scores, const std::string& filename) {
+    std::vector<size_t> order(cg.vertexCount());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (scores.pageRank[a] != scores.pageRank[b]) return scores.pageRank[a] > scores.pageRank[b];
+        return a < b;
+    });
+
+    CsvWriter csv(filename);
+    csv.header({"Rank","Type","ID","Name","Group","Degree","WeightedDegree","PageRank","Betweenness"});
+    int rank = 0;
+    for (size_t v : order) {
+        int id = cg.entityId[v];
+        bool isARG = cg.isARG[v];
+        csv.row(++rank, isARG ? "ARG" : "MGE", id,
+                isARG ? getARGName(id) : getMGEName(id),
+                isARG ? getARGGroupName(id) : getMGEGroupName(id),
+                scores.degree[v], scores.weightedDegree[v], scores.pageRank[v], scores.betweenness[v]);
+    }
+    csv.close();
+}
+
+
+/* Ranked centrality tables for the aggregated network and each timepoint category layer */
+void writeCentralityCSVs(const Graph& g, const std::string& outputPrefix, size_t betweennessSamples) {
+    std::vector<std::pair<std::string, std::function<bool(Timepoint)>>> layers = {
+        {"all",   nullptr},
+        {"donor", [](Timepoint tp) { return isDonor(tp); }},
+        {"pre",   [](Timepoint tp) { return isPreFMT(tp); }},
+    };
+    // One layer per window of the active post-FMT scheme
+    const PostWindowScheme& windows = activePostWindows();
+    for (int bin = 1; bin <= windows.binCount(); ++bin)
+        layers.emplace_back(windows.windows()[bin - 1].label, [&windows, bin](Timepoint tp) { return windows.binOf(tp) == bin; });
+
+    for (const auto& [name, include] : layers) {
+        CompactGraph cg = buildColocalizationCSR(g, include);
+        CentralityScores scores = computeCentrality(cg, betweennessSamples);
+        writeCentralityCSV(cg, scores, outputPrefix + "_" + name + ".csv");
+        std::cout << "Centrality (" << name << "): vertices=" << cg.vertexCount()
+                  << " edges=" << cg.edgeCount() << "\n";
+    }
+}
@@ -1,6 +1,9 @@
 #include "graph_utils.h"
 #include "id_maps.h"
+#include "parallel.h"
+#include <functional>
 #include <iostream>
+#include <tuple>
 #include <unordered_set>
 
 Graph filterGraphByARGAndMGENames(const Graph& g, const std::string& argName, const std::string& mgeName) {
@@ -61,13 +64,13 @@ Graph filterGraphByTimepoint(const Graph& g, const std::string& timepointCategor
 
     auto matchesCategory = [&](Timepoint tp) {
         if (timepointCategory == "donor") {
-            return tp == Timepoint::Donor;
+            return isDonor(tp);
         }
         if (timepointCategory == "pre") {
-            return tp == Timepoint::PreFMT;
+            return isPreFMT(tp);
         }
         if (timepointCategory == "post") {
-            return tp != Timepoint::Donor && tp != Timepoint::PreFMT;
+            return isPostFMT(tp);
         }
         return false;
     };
@@ -256,4 +259,120 @@ Graph filterGraphByDisease(const Graph& g, const std::string& disease, const std
     }
     
     return subgraph;
-}
\ No newline at end of file
+}
+
+
+namespace {
+
+struct SideRollup {
+    std::unordered_map<int, int> coarseOf;          // entity id -> group id
+    std::vector<std::string> labels;
+    std::vector<size_t> members;
+    std::vector<bool> requiresSNPConfirmation;      // any member does
+};
+
+// Group ids follow the sorted labels, so they do not depend on how the graph was built
+SideRollup rollupSide(const Graph& g, bool isARG, const std::function<std::string(int)>& labelOf) {
+    std::map<std::string, std::set<int>> byLabel;
+    std::unordered_map<int, bool> snp;
+    auto add = [&](const Node& n) {
+        if (n.isARG != isARG) return;
+        byLabel[labelOf(n.id)].insert(n.id);
+        snp[n.id] = snp[n.id] || n.requiresSNPConfirmation;
+    };
+    for (const Node& n : g.nodes) add(n);
+    for (const Edge& e : g.edges) {
+        add(e.source);
+        add(e.target);
+    }
+
+    SideRollup side;
+    for (const auto& [label, ids] : byLabel) {
+        const int group = static_cast<int>(side.labels.size());
+        side.labels.push_back(label);
+        side.members.push_back(ids.size());
+        bool needed = false;
+        for (int id : ids) {
+            side.coarseOf[id] = group;
+            needed = needed || snp[id];
+        }
+        side.requiresSNPConfirmation.push_back(needed);
+    }
+    return side;
+}
+
+std::string argRollupLabel(int id, ARGRollup level) {
+    if (level == ARGRollup::Group) return getARGGroupName(id);
+    auto it = argResistanceMap.find(id);
+    return it != argResistanceMap.end() ? it->second : "Unknown Resistance Class";
+}
+
+struct MergedEdge {
+    std::set<int> individuals;
+    int weight = 0;
+};
+
+using CoarseEdgeKey = std::tuple<Node, Node, bool>;
+
+} // namespace
+
+
+CoarseGraph coarsenGraph(const Graph& g, const CoarsenSpec& spec, size_t threads) {
+    CoarseGraph coarse;
+    coarse.spec = spec;
+
+    SideRollup args, mges;
+    if (spec.arg != ARGRollup::None) {
+        args = rollupSide(g, true, [&](int id) { return argRollupLabel(id, spec.arg); });
+        coarse.argLabels = args.labels;
+        coarse.argMembers = args.members;
+    }
+    if (spec.mge != MGERollup::None) {
+        mges = rollupSide(g, false, [](int id) { return getMGEGroupName(id); });
+        coarse.mgeLabels = mges.labels;
+        coarse.mgeMembers = mges.members;
+    }
+
+    auto contract = [&](const Node& n) {
+        const bool rolled = n.isARG ? spec.arg != ARGRollup::None : spec.mge != MGERollup::None;
+        if (!rolled) return n;
+        const SideRollup& side = n.isARG ? args : mges;
+        const int group = side.coarseOf.at(n.id);
+        return Node{group, n.isARG, n.timepoint, side.requiresSNPConfirmation[group]};
+    };
+
+    for (const Node& n : g.nodes) coarse.graph.nodes.insert(contract(n));
+
+    // Each worker merges its chunks into its own table; union and sum make the final merge order-free
+    std::vector<const Edge*> edges;
+    edges.reserve(g.edges.size());
+    for (const Edge& e : g.edges) edges.push_back(&e);
+
+    std::vector<std::map<CoarseEdgeKey, MergedEdge>> partial(workerCount(edges.size(), threads));
+    parallelForChunks(edges.size(), [&](size_t begin, size_t end, size_t t) {
+        auto& merged = partial[t];
+        for (size_t i = begin; i < end; ++i) {
+            const Edge& e = *edges[i];
+            MergedEdge& m = merged[{contract(e.source), contract(e.target), e.isColo}];
+            m.individuals.insert(e.individuals.begin(), e.individuals.end());
+            m.weight += e.weight;
+        }
+    }, threads);
+
+    std::map<CoarseEdgeKey, MergedEdge> merged;
+    for (auto& table : partial) {
+        for (auto& [key, m] : table) {
+            MergedEdge& into = merged[key];
+            into.individuals.insert(m.individuals.begin(), m.individuals.end());
+            into.weight += m.weight;
+        }
+    }
+
+    for (auto& [key, m] : merged) {
+        const auto& [source, target, isColo] = key;
+        coarse.graph.nodes.insert(source);
+        coarse.graph.nodes.insert(target);
+        coarse.graph.edges.insert(Edge{source, target, isColo, std::move(m.individuals), m.weight});
+    }
+    return coarse;
+}
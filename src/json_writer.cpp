@@ -0,0 +1,207 @@
+/* Buffered streaming JSON writer */
+#include "../include/json_writer.h"
+#include "../external/json.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+JsonWriter::JsonWriter(const std::string& filename, int indent, size_t bufferSize)
+    : filename_(filename), out_(&buffer_), bufferSize_(bufferSize == 0 ? 1 : bufferSize), indent_(indent)
+{
+    file_ = std::fopen(filename.c_str(), "wb");
+    if (!file_) throw std::runtime_error("Failed to open JSON: " + filename);
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    buffer_.reserve(bufferSize_ + 256);
+}
+
+
+JsonWriter::JsonWriter(std::string* target, int indent)
+    : out_(target), indent_(indent) {}
+
+
+JsonWriter::~JsonWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // close() reports write errors to callers that ask; a destructor cannot
+    }
+}
+
+
+void JsonWriter::newline() {
+    if (indent_ < 0) return;
+    *out_ += '\n';
+    out_->append(scopes_.size() * static_cast<size_t>(indent_), ' ');
+}
+
+
+// Separator and indentation ahead of a value; a value following its key needs none
+void JsonWriter::beginValue() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (scopes_.empty()) return;
+    Scope& scope = scopes_.back();
+    assert(scope.array && "object members need a key");
+    if (!scope.empty) *out_ += ',';
+    scope.empty = false;
+    newline();
+}
+
+
+JsonWriter& JsonWriter::endValue() {
+    if (file_ && buffer_.size() >= bufferSize_) flushBuffer();
+    return *this;
+}
+
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    assert(!scopes_.empty() && !scopes_.back().array && !afterKey_);
+    Scope& scope = scopes_.back();
+#ifndef NDEBUG
+    assert((scope.empty || scope.lastKey < name) && "keys must ascend to match nlohmann's ordering");
+    scope.lastKey = std::string(name);
+#endif
+    if (!scope.empty) *out_ += ',';
+    scope.empty = false;
+    newline();
+    writeString(name);
+    out_->append(indent_ < 0 ? ":" : ": ");
+    afterKey_ = true;
+    return *this;
+}
+
+
+JsonWriter& JsonWriter::beginObject() {
+    beginValue();
+    *out_ += '{';
+    scopes_.emplace_back(false);
+    return *this;
+}
+
+
+JsonWriter& JsonWriter::endObject() {
+    assert(!scopes_.empty() && !scopes_.back().array && !afterKey_);
+    const bool empty = scopes_.back().empty;
+    scopes_.pop_back();
+    if (!empty) newline();
+    *out_ += '}';
+    return endValue();
+}
+
+
+JsonWriter& JsonWriter::beginArray() {
+    beginValue();
+    *out_ += '[';
+    scopes_.emplace_back(true);
+    return *this;
+}
+
+
+JsonWriter& JsonWriter::endArray() {
+    assert(!scopes_.empty() && scopes_.back().array);
+    const bool empty = scopes_.back().empty;
+    scopes_.pop_back();
+    if (!empty) newline();
+    *out_ += ']';
+    return endValue();
+}
+
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    beginValue();
+    writeString(text);
+    return endValue();
+}
+
+
+JsonWriter& JsonWriter::value(bool flag) {
+    beginValue();
+    out_->append(flag ? "true" : "false");
+    return endValue();
+}
+
+
+JsonWriter& JsonWriter::value(double number) {
+    beginValue();
+    if (!std::isfinite(number)) {
+        out_->append("null");
+    } else if (number == std::floor(number) && std::fabs(number) < 1e15) {
+        // Integral values (all the pen widths and weights): digits plus ".0", as nlohmann prints them
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), static_cast<long long>(number));
+        if (number == 0 && std::signbit(number)) out_->append("-");
+        out_->append(digits, result.ptr);
+        out_->append(".0");
+    } else {
+        // nlohmann's Grisu2 output for everything else, so the files stay byte-identical
+        out_->append(nlohmann::json(number).dump());
+    }
+    return endValue();
+}
+
+
+JsonWriter& JsonWriter::null() {
+    beginValue();
+    out_->append("null");
+    return endValue();
+}
+
+
+// Escaping as nlohmann with ensure_ascii off: quote, backslash and control characters only
+void JsonWriter::writeString(std::string_view text) {
+    *out_ += '"';
+    size_t plain = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out_->append(text.data() + plain, i - plain);
+        plain = i + 1;
+        switch (c) {
+            case '"':  out_->append("\\\""); break;
+            case '\\': out_->append("\\\\"); break;
+            case '\b': out_->append("\\b"); break;
+            case '\f': out_->append("\\f"); break;
+            case '\n': out_->append("\\n"); break;
+            case '\r': out_->append("\\r"); break;
+            case '\t': out_->append("\\t"); break;
+            default: {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out_->append(escaped);
+            }
+        }
+    }
+    out_->append(text.data() + plain, text.size() - plain);
+    *out_ += '"';
+}
+
+
+void JsonWriter::flushBuffer() {
+    if (buffer_.empty()) return;
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size())
+        throw std::runtime_error("Failed to write JSON: " + filename_ + ": " + std::strerror(errno));
+    buffer_.clear();
+}
+
+
+void JsonWriter::close() {
+    if (!file_) return;
+    assert(scopes_.empty() && "unterminated JSON document");
+    buffer_ += '\n';
+
+    std::FILE* file = file_;
+    try {
+        flushBuffer();
+    } catch (...) {
+        std::fclose(file);
+        file_ = nullptr;
+        throw;
+    }
+    file_ = nullptr;
+    if (std::fclose(file) != 0) throw std::runtime_error("Failed to close JSON: " + filename_);
+}
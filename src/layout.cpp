@@ -0,0 +1,252 @@
+/* Barnes–Hut force-directed layout mirroring graph.js's d3-force simulation */
+#include "../include/layout.h"
+#include "../include/parallel.h"
+#include "../include/rng.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr double ALPHA_MIN = 0.001;
+constexpr double VELOCITY_DECAY = 0.4;
+constexpr double INITIAL_RADIUS = 10.0;
+constexpr double DISTANCE_MIN2 = 1.0;     // d3 forceManyBody distanceMin squared
+constexpr int MAX_DEPTH = 48;             // deeper leaves keep several points, like coincident ones
+
+// Deterministic stand-in for d3's jiggle(): separates coincident points, lower index to the left
+double jiggle(size_t self, size_t other) {
+    return self < other ? -1e-6 : 1e-6;
+}
+
+
+/* Quadtree over the current positions. Cells aggregate the charge of what they contain and
+ * its |charge|-weighted center; leaves chain their points through `next`. */
+class QuadTree {
+public:
+    struct Cell {
+        Cell(double left, double top, double width) : x0(left), y0(top), size(width) {}
+        double x0, y0, size;
+        double strength = 0.0;
+        double weight = 0.0;
+        double cx = 0.0, cy = 0.0;
+        int child[4] = {-1, -1, -1, -1};
+        int point = -1;
+        bool internal = false;
+    };
+
+    QuadTree(const std::vector<LayoutPoint>& pos, const std::vector<double>& charge)
+        : pos_(pos), next_(pos.size(), -1)
+    {
+        double x0 = pos[0].x, y0 = pos[0].y, x1 = x0, y1 = y0;
+        for (const LayoutPoint& p : pos) {
+            x0 = std::min(x0, p.x); x1 = std::max(x1, p.x);
+            y0 = std::min(y0, p.y); y1 = std::max(y1, p.y);
+        }
+        cells_.reserve(pos.size() * 2);
+        cells_.emplace_back(x0, y0, std::max({x1 - x0, y1 - y0, 1.0}));
+        for (size_t i = 0; i < pos.size(); ++i) insert(static_cast<int>(i));
+
+        // Children are created after their parents, so one reverse sweep aggregates bottom-up
+        for (size_t c = cells_.size(); c-- > 0;) {
+            Cell& cell = cells_[c];
+            double sx = 0.0, sy = 0.0;
+            if (cell.internal) {
+                for (int q : cell.child) {
+                    if (q < 0) continue;
+                    const Cell& sub = cells_[q];
+                    cell.strength += sub.strength;
+                    cell.weight += sub.weight;
+                    sx += sub.cx * sub.weight;
+                    sy += sub.cy * sub.weight;
+                }
+            } else {
+                for (int p = cell.point; p >= 0; p = next_[p]) {
+                    const double w = std::fabs(charge[p]);
+                    cell.strength += charge[p];
+                    cell.weight += w;
+                    sx += pos_[p].x * w;
+                    sy += pos_[p].y * w;
+                }
+            }
+            if (cell.weight > 0) {
+                cell.cx = sx / cell.weight;
+                cell.cy = sy / cell.weight;
+            }
+        }
+    }
+
+    const std::vector<Cell>& cells() const { return cells_; }
+    int next(int point) const { return next_[point]; }
+
+private:
+    int childFor(int c, const LayoutPoint& p) {
+        const double half = cells_[c].size / 2;
+        const int q = (p.x >= cells_[c].x0 + half ? 1 : 0) + (p.y >= cells_[c].y0 + half ? 2 : 0);
+        if (cells_[c].child[q] < 0) {
+            const double x0 = cells_[c].x0 + (q & 1 ? half : 0), y0 = cells_[c].y0 + (q & 2 ? half : 0);
+            cells_[c].child[q] = static_cast<int>(cells_.size());
+            cells_.emplace_back(x0, y0, half);
+        }
+        return cells_[c].child[q];
+    }
+
+    void insert(int i) {
+        int c = 0;
+        for (int depth = 0;; ++depth) {
+            if (cells_[c].internal) {
+                c = childFor(c, pos_[i]);
+                continue;
+            }
+            const int j = cells_[c].point;
+            if (j < 0) {
+                cells_[c].point = i;
+                return;
+            }
+            if ((pos_[j].x == pos_[i].x && pos_[j].y == pos_[i].y) || depth >= MAX_DEPTH) {
+                next_[i] = j;
+                cells_[c].point = i;
+                return;
+            }
+            // Split the leaf: its chain (all at one position) moves down as a whole
+            cells_[c].internal = true;
+            cells_[c].point = -1;
+            const int sub = childFor(c, pos_[j]);
+            cells_[sub].point = j;
+            c = childFor(c, pos_[i]);
+            if (c != sub) {
+                cells_[c].point = i;
+                return;
+            }
+        }
+    }
+
+    const std::vector<LayoutPoint>& pos_;
+    std::vector<int> next_;
+    std::vector<Cell> cells_;
+};
+
+
+// d3 forceManyBody for node i: far cells act through their center of charge
+void applyCharge(const QuadTree& tree, const std::vector<LayoutPoint>& pos, const std::vector<double>& charge,
+                 size_t i, double alpha, double theta2, LayoutPoint& velocity, std::vector<int>& stack) {
+    const auto& cells = tree.cells();
+    const LayoutPoint& self = pos[i];
+    stack.assign(1, 0);
+    while (!stack.empty()) {
+        const auto& cell = cells[stack.back()];
+        stack.pop_back();
+        if (cell.strength == 0) continue;
+
+        double dx = cell.cx - self.x, dy = cell.cy - self.y;
+        double l = dx * dx + dy * dy;
+        if (cell.size * cell.size / theta2 < l) {
+            if (l < DISTANCE_MIN2) l = std::sqrt(DISTANCE_MIN2 * l);
+            velocity.x += dx * cell.strength * alpha / l;
+            velocity.y += dy * cell.strength * alpha / l;
+            continue;
+        }
+        if (cell.internal) {
+            for (int q : cell.child)
+                if (q >= 0) stack.push_back(q);
+            continue;
+        }
+        for (int p = cell.point; p >= 0; p = tree.next(p)) {
+            const size_t other = static_cast<size_t>(p);
+            if (other == i) continue;
+            dx = pos[other].x - self.x;
+            dy = pos[other].y - self.y;
+            if (dx == 0) dx = jiggle(i, other);
+            if (dy == 0) dy = jiggle(i, other);
+            l = dx * dx + dy * dy;
+            if (l < DISTANCE_MIN2) l = std::sqrt(DISTANCE_MIN2 * l);
+            velocity.x += dx * charge[other] * alpha / l;
+            velocity.y += dy * charge[other] * alpha / l;
+        }
+    }
+}
+
+} // namespace
+
+
+std::vector<LayoutPoint> forceDirectedLayout(size_t nodeCount, const std::vector<LayoutEdge>& edges, const LayoutOptions& options) {
+    std::vector<LayoutPoint> pos(nodeCount), vel(nodeCount);
+    if (nodeCount == 0) return pos;
+
+    std::vector<size_t> degree(nodeCount, 0);
+    for (const LayoutEdge& e : edges) {
+        if (e.source >= nodeCount || e.target >= nodeCount)
+            throw std::invalid_argument("forceDirectedLayout: edge endpoint out of range");
+        ++degree[e.source];
+        ++degree[e.target];
+    }
+
+    // Seeded start in a disc about as large as d3's phyllotaxis spiral for this many nodes
+    const double radius = INITIAL_RADIUS * std::sqrt(0.5 + static_cast<double>(nodeCount));
+    const double twoPi = 2.0 * std::acos(-1.0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        SplitMix64 rng = SplitMix64::stream(options.seed, i);
+        const double r = radius * std::sqrt(static_cast<double>(rng.next() >> 11) * 0x1.0p-53);
+        const double angle = twoPi * static_cast<double>(rng.next() >> 11) * 0x1.0p-53;
+        pos[i] = {options.centerX + r * std::cos(angle), options.centerY + r * std::sin(angle)};
+    }
+
+    const std::vector<double> charge(nodeCount, options.charge);
+    const double theta2 = options.theta * options.theta;
+    const size_t iterations = std::max<size_t>(1, options.iterations);
+    const double alphaDecay = 1.0 - std::pow(ALPHA_MIN, 1.0 / static_cast<double>(iterations));
+    double alpha = 1.0;
+
+    for (size_t tick = 0; tick < iterations; ++tick) {
+        alpha -= alpha * alphaDecay;
+
+        // Link springs (d3 forceLink): sequential, each link moves both of its ends
+        for (const LayoutEdge& e : edges) {
+            if (e.source == e.target) continue;
+            const double strength = 1.0 / static_cast<double>(std::min(degree[e.source], degree[e.target]));
+            const double bias = static_cast<double>(degree[e.source]) / static_cast<double>(degree[e.source] + degree[e.target]);
+            double dx = pos[e.target].x + vel[e.target].x - pos[e.source].x - vel[e.source].x;
+            double dy = pos[e.target].y + vel[e.target].y - pos[e.source].y - vel[e.source].y;
+            if (dx == 0) dx = jiggle(e.source, e.target);
+            if (dy == 0) dy = jiggle(e.source, e.target);
+            const double length = std::sqrt(dx * dx + dy * dy);
+            const double scale = (length - e.distance) / length * alpha * strength;
+            dx *= scale;
+            dy *= scale;
+            vel[e.target].x -= dx * bias;
+            vel[e.target].y -= dy * bias;
+            vel[e.source].x += dx * (1 - bias);
+            vel[e.source].y += dy * (1 - bias);
+        }
+
+        // Many-body charge through Barnes–Hut; each node writes only its own velocity
+        const QuadTree tree(pos, charge);
+        parallelForChunks(nodeCount, [&](size_t begin, size_t end, size_t) {
+            std::vector<int> stack;
+            for (size_t i = begin; i < end; ++i) applyCharge(tree, pos, charge, i, alpha, theta2, vel[i], stack);
+        }, options.threads);
+
+        // Centering (d3 forceCenter moves positions) and x/y gravity
+        double meanX = 0.0, meanY = 0.0;
+        for (const LayoutPoint& p : pos) {
+            meanX += p.x;
+            meanY += p.y;
+        }
+        meanX = meanX / static_cast<double>(nodeCount) - options.centerX;
+        meanY = meanY / static_cast<double>(nodeCount) - options.centerY;
+        for (size_t i = 0; i < nodeCount; ++i) {
+            pos[i].x -= meanX;
+            pos[i].y -= meanY;
+            vel[i].x += (options.centerX - pos[i].x) * options.gravity * alpha;
+            vel[i].y += (options.centerY - pos[i].y) * options.gravity * alpha;
+        }
+
+        for (size_t i = 0; i < nodeCount; ++i) {
+            vel[i].x *= 1.0 - VELOCITY_DECAY;
+            vel[i].y *= 1.0 - VELOCITY_DECAY;
+            pos[i].x += vel[i].x;
+            pos[i].y += vel[i].y;
+        }
+    }
+    return pos;
+}
@@ -1,5 +1,7 @@
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
+#include <cstdlib>
 #include "../include/Timepoint.h"
 #include "../include/graph.h"
 #include "../include/parser.h"
@@ -10,6 +12,20 @@
 #include "../include/graph_utils.h"
 #include "../include/export_graph_json.h" 
 #include "../include/config_loader.h"  
+#include "../include/motifs.h"
+#include "../include/graph_analysis.h"
+#include "../include/community.h"
+#include "../include/projection.h"
+#include "../include/similarity.h"
+#include "../include/minhash.h"
+#include "../include/survival.h"
+#include "../include/post_windows.h"
+#include "../include/enrichment.h"
+#include "../include/null_model.h"
+#include "../include/query_engine.h"
+#include "../include/server.h"
+#include "../include/stage_cache.h"
+#include "../include/stage_scheduler.h"
 
 /* Main entry point: parse arguments, load data, call functions */
 
@@ -19,67 +35,342 @@ fs::path data_file;
 fs::path interaction_json_path;
 fs::path parent_json_path;
 fs::path temporal_dynamics_json_path;
+fs::path parent_shards_dir;
+fs::path coarse_json_path;
+CoarsenSpec coarsen_spec;
 fs::path top_entities_output_dir;
 fs::path top_colocalizations_output;
+fs::path top_colocalizations_by_group_output;
+fs::path motifs_patient_output;
+fs::path centrality_output_prefix;
+fs::path motifs_disease_output;
+fs::path projections_output_dir;
+int projection_min_shared_partners = 1;
+int projection_min_shared_patients = 1;
+fs::path similarity_output_dir;
+fs::path similar_patients_output;
+fs::path survival_output;
+fs::path survival_json_path;
+bool compact_viz_json = false;
+GraphJsonOptions graph_json_options;
+fs::path post_windows_output;
+std::vector<PostWindowScheme> post_window_schemes;
+fs::path enrichment_output;
+EnrichmentOptions enrichment_options;
+fs::path null_model_output;
+NullModelOptions null_model_options;
 fs::path disease_type_output;
 fs::path mge_group_output;
+fs::path top_arg_output;
+fs::path top_mge_output;
+fs::path emerge_output;
+fs::path disappear_output;
+fs::path transfer_output;
+fs::path persist_output;
+fs::path cache_dir;
+bool cache_enabled = true;
+size_t scheduler_threads = 0;
 
 
+// Window labels and day ranges of a scheme, for the keys of stages that bin post-FMT timepoints
+static std::string schemeSignature(const PostWindowScheme& scheme) {
+    std::string signature = scheme.name();
+    for (const auto& w : scheme.windows())
+        signature += ";" + w.label + "," + std::to_string(w.fromDay) + "," + std::to_string(w.toDay) + "," + w.color;
+    return signature;
+}
+
+
+const char* const USAGE =
+    "Usage: CoNet [--query \"<predicates>\" [--out <file.csv>]]\n"
+    "       CoNet --serve [--port <n> | --socket <path>]\n"
+    "       CoNet --no-cache\n"
+    "  Without arguments the full analysis pipeline runs, skipping stages whose inputs are unchanged.\n"
+    "  --query  answer one predicate query and exit, e.g.\n"
+    "           --query \"disease = rCDI and timepoint in (pre, post1) and mge_group = plasmid\"\n"
+    "  --out    write every matching record to a CSV instead of printing the first rows\n"
+    "  --serve  keep the graph in memory and answer /query, /subgraph and /timeline over HTTP\n"
+    "           on 127.0.0.1:8080, another --port, or a Unix --socket\n"
+    "  --no-cache  rerun every stage and leave the stage cache untouched\n";
+
+
+int main(int argc, char* argv[]) {
+    std::string query_text;
+    std::string query_output;
+    bool serve = false;
+    bool no_cache = false;
+    ServeOptions serve_options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--query" || arg == "--out") && i + 1 < argc) {
+            (arg == "--query" ? query_text : query_output) = argv[++i];
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg == "--no-cache") {
+            no_cache = true;
+        } else if (arg == "--port" && i + 1 < argc) {
+            char* end = nullptr;
+            const long port = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || port < 1 || port > 65535) {
+                std::cerr << "Invalid --port: " << argv[i] << " (expected 1-65535)\n";
+                return 1;
+            }
+            serve_options.port = static_cast<int>(port);
+        } else if (arg == "--socket" && i + 1 < argc) {
+            serve_options.unixSocket = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << USAGE;
+            return 0;
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << "\n" << USAGE;
+            return 1;
+        }
+    }
 
-int main() {
     try {
         Config cfg = loadConfig("config/paths.json");
         data_file = fs::path(cfg.input_data_path);
         interaction_json_path = fs::path(cfg.viz_interaction);
         parent_json_path = fs::path(cfg.viz_parent);
+        parent_shards_dir = fs::path(cfg.viz_parent_shards);
+        coarse_json_path = fs::path(cfg.viz_coarse);
+        if (cfg.viz_coarse_arg_level == "none") coarsen_spec.arg = ARGRollup::None;
+        else if (cfg.viz_coarse_arg_level == "group") coarsen_spec.arg = ARGRollup::Group;
+        else if (cfg.viz_coarse_arg_level == "resistance_class") coarsen_spec.arg = ARGRollup::ResistanceClass;
+        else throw std::runtime_error("Unknown ARG coarsening level: " + cfg.viz_coarse_arg_level);
+        if (cfg.viz_coarse_mge_level == "none") coarsen_spec.mge = MGERollup::None;
+        else if (cfg.viz_coarse_mge_level == "group") coarsen_spec.mge = MGERollup::Group;
+        else throw std::runtime_error("Unknown MGE coarsening level: " + cfg.viz_coarse_mge_level);
         temporal_dynamics_json_path = fs::path(cfg.viz_temporal_dynamics);
         top_entities_output_dir = fs::path(cfg.output_base);
         top_colocalizations_output = fs::path(cfg.output_top_colocalizations);
+        top_colocalizations_by_group_output = fs::path(cfg.output_top_colocalizations_by_group);
+        motifs_patient_output = fs::path(cfg.output_motifs_patient);
+        centrality_output_prefix = fs::path(cfg.output_centrality_prefix);
+        motifs_disease_output = fs::path(cfg.output_motifs_disease);
+        projections_output_dir = fs::path(cfg.output_projections);
+        projection_min_shared_partners = cfg.projection_min_shared_partners;
+        projection_min_shared_patients = cfg.projection_min_shared_patients;
+        similarity_output_dir = fs::path(cfg.output_similarity);
+        similar_patients_output = fs::path(cfg.output_similar_patients);
+        survival_output = fs::path(cfg.output_survival);
+        survival_json_path = fs::path(cfg.viz_survival);
+        compact_viz_json = cfg.viz_compact_json;
+        if (cfg.viz_graph_schema != "records" && cfg.viz_graph_schema != "columnar")
+            throw std::runtime_error("Unknown viz graph schema: " + cfg.viz_graph_schema);
+        graph_json_options.compact = cfg.viz_compact_json;
+        graph_json_options.columnar = cfg.viz_graph_schema == "columnar";
+        graph_json_options.layout = cfg.layout_enabled;
+        graph_json_options.layoutOptions.iterations = static_cast<size_t>(std::max(1, cfg.layout_iterations));
+        graph_json_options.layoutOptions.seed = static_cast<uint64_t>(cfg.layout_seed);
+        graph_json_options.layoutOptions.theta = cfg.layout_theta;
+        post_windows_output = fs::path(cfg.output_post_windows);
+        post_window_schemes = cfg.post_window_schemes;
+        enrichment_output = fs::path(cfg.output_enrichment);
+        enrichment_options.permutations = static_cast<size_t>(cfg.enrichment_permutations);
+        enrichment_options.seed = static_cast<uint64_t>(cfg.enrichment_seed);
+        enrichment_options.minPatients = cfg.enrichment_min_patients;
+        null_model_output = fs::path(cfg.output_null_model);
+        null_model_options.replicates = static_cast<size_t>(cfg.null_model_replicates);
+        null_model_options.tradesPerRow = static_cast<size_t>(cfg.null_model_trades_per_row);
+        null_model_options.seed = static_cast<uint64_t>(cfg.null_model_seed);
+        if (cfg.null_model_top_k < 1)
+            throw std::runtime_error("null_model.top_k must be at least 1, got " + std::to_string(cfg.null_model_top_k));
+        null_model_options.topK = static_cast<unsigned int>(cfg.null_model_top_k);
+        disease_type_output = fs::path(cfg.output_disease);
+        mge_group_output = fs::path(cfg.output_mge_group);
+        top_arg_output = fs::path(cfg.output_top_arg);
+        top_mge_output = fs::path(cfg.output_top_mge);
+        emerge_output = fs::path(cfg.output_emerge);
+        disappear_output = fs::path(cfg.output_disappear);
+        transfer_output = fs::path(cfg.output_transfer);
+        persist_output = fs::path(cfg.output_persist);
+        cache_dir = fs::path(cfg.cache_dir);
+        cache_enabled = cfg.cache_enabled && !no_cache;
+        scheduler_threads = static_cast<size_t>(std::max(0, cfg.scheduler_threads));
+        createOutputDirectories(cfg);
+
+        auto active = std::find_if(post_window_schemes.begin(), post_window_schemes.end(),
+                                   [&](const PostWindowScheme& s) { return s.name() == cfg.active_post_windows; });
+        if (active == post_window_schemes.end())
+            throw std::runtime_error("Unknown post-FMT window scheme: " + cfg.active_post_windows);
+        setActivePostWindows(*active);
 
 
     } catch (const std::exception& e) {
         std::cerr << "Config error: " << e.what() << "\n";
         return 1;
     }
+    // Parse flags; part of every stage's cache key
+    const bool include_snp_confirmation_args = true;
+    const bool exclude_metals = false;
+
     Graph g;
     std::map<int, std::string> patientToDiseaseMap;
     std::unordered_map<Node, std::unordered_set<Node>> adjacency;
-
-    // parse the data file and construct the graph (true to exclude ARGs requiring SNP confirmation, true to exclude metals)
-    parseData(data_file, g, patientToDiseaseMap, true, false);
-
-    addTemporalEdges(g);  
-    buildAdjacency(g, adjacency);
-
-    /******************************** Graph Statistics  ************************************/
-    writeGraphStatisticsCSV(g, adjacency, "viz/output/graph_statistics.csv");
-
-    /******************************** Traversal of Graph  ************************************/
     std::map<std::pair<int, int>, std::multiset<Timepoint>> colocalizationTimeline;
-    traverseAdjacency(g, adjacency, colocalizationTimeline);
-
-    /******************************** Traversal of Graph  ************************************/
     std::map<std::tuple<int, int, int>, std::set<Timepoint>> colocalizationByIndividual;
-    traverseGraph(g, colocalizationByIndividual);
-    std::map<std::pair<int, int>, std::set<int>> globalPairToPatients;
-    
 
-    /********************************* Colocalizations by Timepoints ************************************/
-    writeAllDiseasesTemporalDynamicsCounts(colocalizationByIndividual, patientToDiseaseMap);
-    writeTemporalDynamicsCountsForMGEGroup(colocalizationByIndividual);
-    mostProminentEntities(g);
-    getTopARGMGEPairsByFrequencyWODonor(colocalizationByIndividual, 10, patientToDiseaseMap, top_colocalizations_output.string());
-    
+    /******************************** Query Mode  ************************************/
+    if (!query_text.empty()) {
+        parseData(data_file, g, patientToDiseaseMap, include_snp_confirmation_args, exclude_metals);
+        try {
+            QueryIndex index(g, patientToDiseaseMap);
+            QueryResult result = index.run(query_text);
+            if (query_output.empty()) {
+                printQueryResult(index, result, std::cout);
+            } else {
+                writeQueryResultCSV(index, result, query_output);
+                std::cout << "Plan: " << result.plan.explain() << "\n"
+                          << "Wrote " << result.records.size() << " records to " << query_output << "\n";
+            }
+        } catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    /******************************** Server Mode  ************************************/
+    if (serve) {
+        parseData(data_file, g, patientToDiseaseMap, include_snp_confirmation_args, exclude_metals);
+        addTemporalEdges(g);
+        CommunityMap communities = detectCommunities(g, patientToDiseaseMap);
+        GraphService service(g, patientToDiseaseMap, communities);
+        return serveGraph(service, serve_options);
+    }
 
-    exportColocalizations(g, colocalizationByIndividual);
+    /******************************** Stage Cache  ************************************/
+    uint64_t baseKey = codeVersionHash(argc > 0 ? argv[0] : nullptr);
+    const uint64_t dataHash = hashFileContents(data_file.string());
+    baseKey = fnv1a64(&dataHash, sizeof(dataHash), baseKey);
+    baseKey = fnv1a64(std::string(include_snp_confirmation_args ? "snp" : "no_snp") + (exclude_metals ? ",no_metals" : ",metals"), baseKey);
+    StageCache cache(cache_dir.string(), baseKey, cache_enabled);
 
-    // /************************************* Graph Visualization ***********************************/
+    const std::string windows = schemeSignature(activePostWindows());
+    const std::string json_style = compact_viz_json ? "compact" : "pretty";
+    const LayoutOptions& layout = graph_json_options.layoutOptions;
+    const std::string layout_signature = graph_json_options.layout
+        ? "layout " + std::to_string(layout.iterations) + " " + std::to_string(layout.seed) + " " + std::to_string(layout.theta)
+        : "no layout";
+    const std::string coarse_levels = "arg " + std::to_string(static_cast<int>(coarsen_spec.arg))
+        + " mge " + std::to_string(static_cast<int>(coarsen_spec.mge));
+    std::string allWindows;
+    for (const auto& scheme : post_window_schemes) allWindows += schemeSignature(scheme) + "|";
+    const TemporalDynamicsPaths temporal_dynamics_paths{emerge_output.string(), disappear_output.string(),
+                                                        transfer_output.string(), persist_output.string()};
 
-    Graph amrGraphNet = g;
-    exportGraphToJsonSimple(amrGraphNet, interaction_json_path.string(), patientToDiseaseMap);
-    exportParentGraphToJson(amrGraphNet, parent_json_path.string(), patientToDiseaseMap, true);
-    exportColocalizationsToJSONByDisease(colocalizationByIndividual, patientToDiseaseMap, temporal_dynamics_json_path.string());
+    /******************************** Pipeline Stages  ************************************/
+    // Each stage reads one of the shared inputs (graph, adjacency, colocalizations) and writes its own outputs,
+    // so the scheduler runs them side by side; listed in the order their console output is printed
+    struct PipelineStage {
+        StageSpec spec;
+        std::string input;
+        std::function<void()> run;
+    };
+    const std::vector<PipelineStage> stages = {
+        {{"graph_statistics", {}, {"viz/output/graph_statistics.csv"}}, "adjacency", [&]() {
+            writeGraphStatisticsCSV(g, adjacency, "viz/output/graph_statistics.csv");
+        }},
+        {{"centrality", {windows}, {centrality_output_prefix.string()}}, "graph", [&]() {
+            writeCentralityCSVs(g, centrality_output_prefix.string());
+        }},
+        {{"projections", {std::to_string(projection_min_shared_partners), std::to_string(projection_min_shared_patients)},
+          {projections_output_dir.string()}}, "graph", [&]() {
+            writeAllProjections(g, patientToDiseaseMap, projections_output_dir.string(),
+                                projection_min_shared_partners, projection_min_shared_patients);
+        }},
+        {{"null_model", {std::to_string(null_model_options.replicates), std::to_string(null_model_options.tradesPerRow),
+                         std::to_string(null_model_options.seed), std::to_string(null_model_options.topK)},
+          {null_model_output.string()}}, "graph", [&]() {
+            writeNullModelCSV(runDegreePreservingNullModel(g, null_model_options), null_model_output.string());
+        }},
+        {{"grouped_counts", {windows}, {disease_type_output.string(), mge_group_output.string()}}, "colocalizations", [&]() {
+            writeGroupedTemporalDynamicsCounts(colocalizationByIndividual, patientToDiseaseMap,
+                                               disease_type_output.string(), mge_group_output.string());
+        }},
+        {{"post_windows", {allWindows}, {post_windows_output.string()}}, "colocalizations", [&]() {
+            writePostWindowSummaryCSV(colocalizationByIndividual, patientToDiseaseMap, PostWindowSet(post_window_schemes), post_windows_output.string());
+        }},
+        {{"top_entities", {}, {top_arg_output.string(), top_mge_output.string()}}, "graph", [&]() {
+            mostProminentEntities(g, top_arg_output.string(), top_mge_output.string());
+        }},
+        {{"top_colocalizations", {"10"}, {top_colocalizations_output.string()}}, "colocalizations", [&]() {
+            getTopARGMGEPairsByFrequencyWODonor(colocalizationByIndividual, 10, patientToDiseaseMap, top_colocalizations_output.string());
+        }},
+        {{"top_colocalizations_by_group", {"10"}, {top_colocalizations_by_group_output.string()}}, "colocalizations", [&]() {
+            getTopARGMGEPairsByGroup(colocalizationByIndividual, 10, patientToDiseaseMap, top_colocalizations_by_group_output.string());
+        }},
+        {{"enrichment", {std::to_string(enrichment_options.permutations), std::to_string(enrichment_options.seed),
+                         std::to_string(enrichment_options.minPatients)}, {enrichment_output.string()}}, "colocalizations", [&]() {
+            writeEnrichmentCSV(runDiseaseEnrichment(colocalizationByIndividual, patientToDiseaseMap, enrichment_options), enrichment_output.string());
+        }},
+        {{"temporal_dynamics", {json_style}, {temporal_dynamics_json_path.string(), emerge_output.string(), disappear_output.string(),
+                                   transfer_output.string(), persist_output.string()}}, "colocalizations", [&]() {
+            exportTemporalDynamics(colocalizationByIndividual, patientToDiseaseMap, temporal_dynamics_paths, temporal_dynamics_json_path.string(), compact_viz_json);
+        }},
+        /********************************* Patient Similarity ************************************/
+        {{"similarity", {}, {similarity_output_dir.string()}}, "colocalizations", [&]() {
+            writePatientSimilarity(colocalizationByIndividual, patientToDiseaseMap, similarity_output_dir.string());
+        }},
+        {{"similar_patients", {"5"}, {similar_patients_output.string()}}, "colocalizations", [&]() {
+            writeSimilarPatientsCSV(colocalizationByIndividual, patientToDiseaseMap, 5, similar_patients_output.string());
+        }},
+        /********************************* Persistence / Emergence Survival ************************************/
+        {{"survival", {}, {survival_output.string(), survival_json_path.string()}}, "colocalizations", [&]() {
+            KMCurves kmCurves = computeKaplanMeierCurves(colocalizationByIndividual, patientToDiseaseMap);
+            writeKaplanMeierCSV(kmCurves, survival_output.string());
+            writeKaplanMeierJSON(kmCurves, survival_json_path.string());
+        }},
+        /********************************* Temporal Motifs ************************************/
+        {{"motifs", {}, {motifs_patient_output.string(), motifs_disease_output.string()}}, "graph", [&]() {
+            std::map<int, MotifCounts> motifsByPatient = countTemporalMotifs(g);
+            writeMotifCountsCSV(motifsByPatient, patientToDiseaseMap, motifs_patient_output.string(), motifs_disease_output.string());
+        }},
+        /************************************* Graph Visualization ***********************************/
+        {{"viz", {windows, json_style, graph_json_options.columnar ? "columnar" : "records", layout_signature},
+                 {interaction_json_path.string(), parent_json_path.string(), parent_shards_dir.string()}}, "graph", [&]() {
+            Graph amrGraphNet = g;
+            CommunityMap communities = detectCommunities(amrGraphNet, patientToDiseaseMap);
+            exportGraphToJsonSimple(amrGraphNet, interaction_json_path.string(), patientToDiseaseMap, communities, graph_json_options);
+            exportParentGraphWithShards(amrGraphNet, parent_json_path.string(), parent_shards_dir.string(),
+                                        patientToDiseaseMap, true, graph_json_options);
+        }},
+        {{"viz_coarse", {windows, json_style, graph_json_options.columnar ? "columnar" : "records", layout_signature,
+                         coarse_levels},
+                        {coarse_json_path.string()}}, "graph", [&]() {
+            CoarseGraph coarse = coarsenGraph(g, coarsen_spec);
+            exportCoarseGraphToJson(coarse, coarse_json_path.string(), patientToDiseaseMap, graph_json_options);
+        }},
+    };
 
+    // Shared inputs are only built when a stage that reads them is out of date, so a fully cached run never parses the data file
+    std::set<std::string> stale_inputs;
+    for (const auto& stage : stages)
+        if (!cache.upToDate(stage.spec)) stale_inputs.insert(stage.input);
+    const bool need_colocalizations = stale_inputs.count("colocalizations") > 0;
+    const bool need_adjacency = need_colocalizations || stale_inputs.count("adjacency") > 0;
+    const bool need_graph = need_adjacency || stale_inputs.count("graph") > 0;
+
+    StageScheduler scheduler(scheduler_threads);
+    scheduler.add("graph", {}, [&]() {
+        if (!need_graph) return;
+        // parse the data file and construct the graph (true to exclude ARGs requiring SNP confirmation, true to exclude metals)
+        parseData(data_file, g, patientToDiseaseMap, include_snp_confirmation_args, exclude_metals);
+        addTemporalEdges(g);
+    });
+    scheduler.add("adjacency", {"graph"}, [&]() {
+        if (need_adjacency) buildAdjacency(g, adjacency);
+    });
+    /******************************** Traversal of Graph  ************************************/
+    scheduler.add("colocalizations", {"adjacency"}, [&]() {
+        if (!need_colocalizations) return;
+        traverseAdjacency(g, adjacency, colocalizationTimeline);
+        traverseGraph(g, colocalizationByIndividual);
+    });
+    for (const auto& stage : stages)
+        scheduler.add(stage.spec.name, {stage.input}, [&]() { cache.run(stage.spec, stage.run); });
+    scheduler.run();
 
     return 0;
 
@@ -0,0 +1,142 @@
+/* MinHash signatures and LSH banding for near-duplicate set search */
+#include "../include/minhash.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t packPair(int a, int b) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b);
+}
+
+} // namespace
+
+
+double MinHashIndex::estimateJaccard(size_t a, size_t b) const {
+    const uint64_t* sa = signature(a);
+    const uint64_t* sb = signature(b);
+    size_t agree = 0;
+    for (size_t h = 0; h < numHashes; ++h) agree += (sa[h] == sb[h]);
+    return numHashes ? static_cast<double>(agree) / numHashes : 0.0;
+}
+
+
+std::vector<std::pair<int, double>> MinHashIndex::query(int setID, size_t k) const {
+    std::vector<std::pair<int, double>> result;
+    auto it = rowOf.find(setID);
+    if (it == rowOf.end()) return result;
+    const size_t row = it->second;
+
+    // Candidates: every row sharing at least one band bucket
+    std::vector<size_t> candidates;
+    for (size_t band = 0; band < buckets.size(); ++band) {
+        uint64_t h = band;
+        for (size_t r = 0; r < rowsPerBand; ++r) h = fmix64(h ^ signature(row)[band * rowsPerBand + r]);
+        auto bucket = buckets[band].find(h);
+        if (bucket == buckets[band].end()) continue;
+        candidates.insert(candidates.end(), bucket->second.begin(), bucket->second.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (size_t other : candidates) {
+        if (other == row) continue;
+        result.emplace_back(ids[other], estimateJaccard(row, other));
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    if (result.size() > k) result.resize(k);
+    return result;
+}
+
+
+MinHashIndex buildMinHashIndex(const std::map<int, std::vector<uint64_t>>& sets, const MinHashOptions& options) {
+    MinHashIndex index;
+    index.numHashes = options.numHashes;
+    const size_t bands = std::max<size_t>(1, std::min(options.bands, options.numHashes));
+    index.rowsPerBand = options.numHashes / bands;
+
+    std::vector<const std::vector<uint64_t>*> members;
+    for (const auto& [id, elements] : sets) {
+        if (elements.empty()) continue;
+        index.rowOf[id] = index.ids.size();
+        index.ids.push_back(id);
+        members.push_back(&elements);
+    }
+
+    // Hash i of element x is fmix64(x ^ seed_i): one pass over each set fills the whole signature
+    std::vector<uint64_t> seeds(options.numHashes);
+    for (size_t h = 0; h < options.numHashes; ++h) seeds[h] = fmix64(options.seed + 0x9e3779b97f4a7c15ULL * (h + 1));
+
+    const size_t n = index.ids.size();
+    index.signatures.assign(n * options.numHashes, std::numeric_limits<uint64_t>::max());
+    parallelFor(n, [&](size_t row) {
+        uint64_t* sig = index.signatures.data() + row * options.numHashes;
+        for (uint64_t x : *members[row]) {
+            const uint64_t base = fmix64(x);
+            for (size_t h = 0; h < options.numHashes; ++h)
+                sig[h] = std::min(sig[h], fmix64(base ^ seeds[h]));
+        }
+    }, options.threads);
+
+    // Band buckets are independent, so each band is indexed by one worker
+    index.buckets.resize(bands);
+    parallelFor(bands, [&](size_t band) {
+        auto& table = index.buckets[band];
+        for (size_t row = 0; row < n; ++row) {
+            uint64_t h = band;
+            for (size_t r = 0; r < index.rowsPerBand; ++r) h = fmix64(h ^ index.signature(row)[band * index.rowsPerBand + r]);
+            table[h].push_back(row);
+        }
+    }, options.threads);
+
+    return index;
+}
+
+
+std::map<int, std::vector<uint64_t>> patientPairSets(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual) {
+    std::map<int, std::vector<uint64_t>> sets;
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        const auto& [patientID, argID, mgeID] = key;
+        sets[patientID].push_back(packPair(argID, mgeID));
+    }
+    return sets;
+}
+
+
+void writeSimilarPatientsCSV(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                             const std::map<int, std::string>& patientToDiseaseMap, size_t k, const std::string& filename) {
+    MinHashIndex index = buildMinHashIndex(patientPairSets(colocalizationByIndividual));
+
+    auto diseaseOf = [&](int patientID) -> std::string {
+        auto it = patientToDiseaseMap.find(patientID);
+        return it != patientToDiseaseMap.end() ? it->second : "Unknown";
+    };
+
+    CsvWriter csv(filename);
+    csv.header({"Patient","Disease","Rank","SimilarPatient","SimilarDisease","EstimatedJaccard"});
+    size_t neighbours = 0;
+    for (int patientID : index.ids) {
+        int rank = 1;
+        for (const auto& [other, estimate] : index.query(patientID, k)) {
+            csv.row(patientID, diseaseOf(patientID), rank++, other, diseaseOf(other), estimate);
+            ++neighbours;
+        }
+    }
+    csv.close();
+    std::cout << "MinHash LSH: " << index.ids.size() << " patients indexed, " << neighbours << " neighbours written\n";
+}
@@ -0,0 +1,198 @@
+/* Count temporal ARG–MGE motifs per patient using bitmask timelines */
+#include "../include/motifs.h"
+#include "../include/analysis.h"
+#include "../include/bits.h"
+#include "../include/csv_writer.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct PatientEntry {
+    int arg;
+    int mge;
+    Timepoint tp;
+};
+
+// Per (ARG, MGE) timeline of one patient: bit k = present at the patient's k-th non-donor sample
+struct PairTimeline {
+    int arg;
+    int mge;
+    bool donor;
+    uint64_t mask;
+};
+
+long long choose2(long long n) { return n * (n - 1) / 2; }
+
+// Counts pairs of ARGs sharing the same (MGE, timepoint bit) event
+long long countCoEvents(std::vector<std::pair<int, int>>& events) {
+    std::sort(events.begin(), events.end());
+    long long total = 0;
+    size_t i = 0;
+    while (i < events.size()) {
+        size_t j = i;
+        while (j < events.size() && events[j] == events[i]) ++j;
+        total += choose2(static_cast<long long>(j - i));
+        i = j;
+    }
+    return total;
+}
+
+MotifCounts countPatientMotifs(std::vector<PatientEntry>& entries) {
+    MotifCounts counts;
+
+    // Patient's own chronological chain of non-donor samples (same ordering as Node::operator<)
+    std::vector<int> sampled;
+    for (const auto& e : entries)
+        if (e.tp != Timepoint::Donor) sampled.push_back(static_cast<int>(e.tp));
+    std::sort(sampled.begin(), sampled.end());
+    sampled.erase(std::unique(sampled.begin(), sampled.end()), sampled.end());
+    if (sampled.size() > 64) sampled.resize(64);
+
+    auto bitOf = [&](Timepoint tp) -> int {
+        auto it = std::lower_bound(sampled.begin(), sampled.end(), static_cast<int>(tp));
+        if (it == sampled.end() || *it != static_cast<int>(tp)) return -1;
+        return static_cast<int>(it - sampled.begin());
+    };
+
+    // Group entries into per-pair timelines (indexed by ARG, then MGE)
+    std::sort(entries.begin(), entries.end(), [](const PatientEntry& a, const PatientEntry& b) {
+        return std::tie(a.arg, a.mge) < std::tie(b.arg, b.mge);
+    });
+    std::vector<PairTimeline> timelines;
+    for (const auto& e : entries) {
+        if (timelines.empty() || timelines.back().arg != e.arg || timelines.back().mge != e.mge)
+            timelines.push_back({e.arg, e.mge, false, 0});
+        if (e.tp == Timepoint::Donor) {
+            timelines.back().donor = true;
+        } else {
+            int bit = bitOf(e.tp);
+            if (bit >= 0) timelines.back().mask |= (uint64_t(1) << bit);
+        }
+    }
+
+    const bool hasPre = !sampled.empty() && sampled.front() == static_cast<int>(Timepoint::PreFMT);
+    const uint64_t preBit = hasPre ? 1 : 0;
+    const uint64_t postBits = ~preBit;
+
+    std::vector<std::pair<int, int>> arrivals;
+    std::vector<std::pair<int, int>> departures;
+
+    // Walk each ARG's block of MGE timelines
+    size_t i = 0;
+    while (i < timelines.size()) {
+        size_t j = i;
+        uint64_t argMask = 0;
+        long long preCarriers = 0, donorCarriers = 0, newPostCarriers = 0, newPostNotDonor = 0;
+        while (j < timelines.size() && timelines[j].arg == timelines[i].arg) {
+            const PairTimeline& t = timelines[j];
+            argMask |= t.mask;
+            bool pre = t.mask & preBit;
+            bool post = t.mask & postBits;
+            if (pre) ++preCarriers;
+            if (t.donor) ++donorCarriers;
+            if (post && !pre) {
+                ++newPostCarriers;
+                if (!t.donor) ++newPostNotDonor;
+            }
+            ++j;
+        }
+        counts.mgeSwitch      += preCarriers * newPostCarriers;
+        counts.donorMgeSwitch += donorCarriers * newPostNotDonor;
+
+        // Arrivals/departures relative to the previous/next sample where the ARG is still present elsewhere
+        for (size_t k = i; k < j; ++k) {
+            uint64_t m = timelines[k].mask;
+            uint64_t arrive = m & ~(m << 1) & (argMask << 1);
+            uint64_t depart = m & ~(m >> 1) & (argMask >> 1);
+            for (; arrive; arrive &= arrive - 1)
+                arrivals.emplace_back(timelines[k].mge, countTrailingZeros(arrive));
+            for (; depart; depart &= depart - 1)
+                departures.emplace_back(timelines[k].mge, countTrailingZeros(depart));
+        }
+        i = j;
+    }
+
+    counts.coMoveOnto = countCoEvents(arrivals);
+    counts.coMoveOff  = countCoEvents(departures);
+    return counts;
+}
+
+} // namespace
+
+
+// Buckets colocalization edges by patient (one scan), then counts each patient's motifs in parallel
+std::map<int, MotifCounts> countTemporalMotifs(const Graph& g) {
+    std::unordered_map<int, std::vector<PatientEntry>> byPatient;
+    for (const Edge& edge : g.edges) {
+        if (!edge.isColo) continue;
+        int arg = edge.source.isARG ? edge.source.id : edge.target.id;
+        int mge = edge.source.isARG ? edge.target.id : edge.source.id;
+        for (int patientID : edge.individuals)
+            byPatient[patientID].push_back({arg, mge, edge.source.timepoint});
+    }
+
+    std::vector<int> patients;
+    patients.reserve(byPatient.size());
+    for (const auto& [patientID, entries] : byPatient) patients.push_back(patientID);
+    std::sort(patients.begin(), patients.end());
+
+    std::vector<MotifCounts> results(patients.size());
+    parallelFor(patients.size(), [&](size_t idx) {
+        results[idx] = countPatientMotifs(byPatient.at(patients[idx]));
+    });
+
+    std::map<int, MotifCounts> motifsByPatient;
+    for (size_t idx = 0; idx < patients.size(); ++idx)
+        motifsByPatient[patients[idx]] = results[idx];
+    return motifsByPatient;
+}
+
+
+std::map<std::string, MotifCounts> aggregateMotifsByDisease(
+    const std::map<int, MotifCounts>& motifsByPatient,
+    const std::map<int, std::string>& patientToDiseaseMap)
+{
+    std::map<std::string, MotifCounts> byDisease;
+    for (const auto& [patientID, counts] : motifsByPatient) {
+        auto it = patientToDiseaseMap.find(patientID);
+        byDisease[it != patientToDiseaseMap.end() ? it->second : "Unknown"] += counts;
+    }
+    return byDisease;
+}
+
+
+void writeMotifCountsCSV(
+    const std::map<int, MotifCounts>& motifsByPatient,
+    const std::map<int, std::string>& patientToDiseaseMap,
+    const std::string& patientCSV,
+    const std::string& diseaseCSV)
+{
+    {
+    CsvWriter csv(patientCSV);
+    csv.header({"Patient","Disease","MGESwitch","DonorMGESwitch","CoMoveOnto","CoMoveOff"});
+    for (const auto& [patientID, c] : motifsByPatient) {
+        auto it = patientToDiseaseMap.find(patientID);
+        csv.row(patientID, it != patientToDiseaseMap.end() ? it->second : "Unknown",
+                c.mgeSwitch, c.donorMgeSwitch, c.coMoveOnto, c.coMoveOff);
+    }
+    csv.close();
+    }
+
+    std::map<std::string, int> patientsPerDisease;
+    for (const auto& [patientID, c] : motifsByPatient) {
+        auto it = patientToDiseaseMap.find(patientID);
+        patientsPerDisease[it != patientToDiseaseMap.end() ? it->second : "Unknown"]++;
+    }
+
+    CsvWriter csv(diseaseCSV);
+    csv.header({"Disease","Patients","MGESwitch","DonorMGESwitch","CoMoveOnto","CoMoveOff"});
+    for (const auto& [disease, c] : aggregateMotifsByDisease(motifsByPatient, patientToDiseaseMap))
+        csv.row(disease, patientsPerDisease[disease], c.mgeSwitch, c.donorMgeSwitch, c.coMoveOnto, c.coMoveOff);
+    csv.close();
+}
@@ -0,0 +1,242 @@
+/* Degree-preserving (curveball) null models of the ARG–MGE bipartite graph */
+#include "../include/null_model.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include "../include/rng.h"
+#include "../include/traversal.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Column-major copy: MGE column -> sorted ARG rows
+struct Transposed {
+    std::vector<size_t> colPtr;
+    std::vector<int> rows;
+};
+
+Transposed transpose(const BipartiteEdgeArray& b) {
+    Transposed t;
+    t.colPtr.assign(b.mgeIds.size() + 1, 0);
+    for (int c : b.cols) t.colPtr[c + 1]++;
+    for (size_t c = 0; c < b.mgeIds.size(); ++c) t.colPtr[c + 1] += t.colPtr[c];
+    t.rows.resize(b.cols.size());
+    std::vector<size_t> fill(t.colPtr.begin(), t.colPtr.end() - 1);
+    for (size_t r = 0; r < b.rows(); ++r)
+        for (size_t i = b.rowPtr[r]; i < b.rowPtr[r + 1]; ++i)
+            t.rows[fill[b.cols[i]]++] = static_cast<int>(r);
+    return t;
+}
+
+size_t intersectionSize(const int* a, const int* aEnd, const int* b, const int* bEnd) {
+    size_t count = 0;
+    while (a < aEnd && b < bEnd) {
+        if (*a < *b) ++a;
+        else if (*b < *a) ++b;
+        else { ++count; ++a; ++b; }
+    }
+    return count;
+}
+
+// For every unordered pair of rows sharing a partner, calls fn(sharedPartners)
+template <typename F>
+void forEachCooccurringPair(const std::vector<size_t>& ptr, const std::vector<int>& items,
+                            const std::vector<size_t>& backPtr, const std::vector<int>& backItems, F&& fn) {
+    const size_t n = ptr.size() - 1;
+    std::vector<int> shared(n, 0);
+    std::vector<int> touched;
+    for (size_t a = 0; a < n; ++a) {
+        for (size_t i = ptr[a]; i < ptr[a + 1]; ++i) {
+            const int partner = items[i];
+            for (size_t j = backPtr[partner]; j < backPtr[partner + 1]; ++j) {
+                const int other = backItems[j];
+                if (other <= static_cast<int>(a)) continue;
+                if (shared[other]++ == 0) touched.push_back(other);
+            }
+        }
+        for (int other : touched) {
+            fn(shared[other]);
+            shared[other] = 0;
+        }
+        touched.clear();
+    }
+}
+
+// Statistics in fixed order: butterflies, ARG–ARG pairs, MGE–MGE pairs, then the top ARG and MGE pairs
+std::vector<double> measure(const BipartiteEdgeArray& b,
+                            const std::vector<std::pair<int, int>>& argPairs,
+                            const std::vector<std::pair<int, int>>& mgePairs) {
+    const Transposed t = transpose(b);
+
+    double butterflies = 0, argCooccurring = 0, mgeCooccurring = 0;
+    forEachCooccurringPair(b.rowPtr, b.cols, t.colPtr, t.rows, [&](int shared) {
+        argCooccurring += 1;
+        butterflies += 0.5 * shared * (shared - 1);
+    });
+    forEachCooccurringPair(t.colPtr, t.rows, b.rowPtr, b.cols, [&](int) { mgeCooccurring += 1; });
+
+    std::vector<double> values = {butterflies, argCooccurring, mgeCooccurring};
+    for (const auto& [x, y] : argPairs)
+        values.push_back(static_cast<double>(intersectionSize(b.cols.data() + b.rowPtr[x], b.cols.data() + b.rowPtr[x + 1],
+                                                              b.cols.data() + b.rowPtr[y], b.cols.data() + b.rowPtr[y + 1])));
+    for (const auto& [x, y] : mgePairs)
+        values.push_back(static_cast<double>(intersectionSize(t.rows.data() + t.colPtr[x], t.rows.data() + t.colPtr[x + 1],
+                                                              t.rows.data() + t.colPtr[y], t.rows.data() + t.colPtr[y + 1])));
+    return values;
+}
+
+// All pairs among the top-K entities that appear in the edge array, in rank order
+std::vector<std::pair<int, int>> topEntityPairs(const Graph& g, bool isARG, unsigned int k, const std::vector<int>& ids) {
+    std::unordered_map<int, int> codeOf;
+    for (size_t i = 0; i < ids.size(); ++i) codeOf[ids[i]] = static_cast<int>(i);
+
+    std::vector<int> codes;
+    for (const auto& [id, count] : getTopKEntities(g, isARG, k)) {
+        auto it = codeOf.find(id);
+        if (it != codeOf.end()) codes.push_back(it->second);
+    }
+    std::vector<std::pair<int, int>> pairs;
+    for (size_t i = 0; i < codes.size(); ++i)
+        for (size_t j = i + 1; j < codes.size(); ++j) pairs.emplace_back(codes[i], codes[j]);
+    return pairs;
+}
+
+} // namespace
+
+
+BipartiteEdgeArray buildBipartiteEdgeArray(const Graph& g) {
+    std::vector<std::pair<int, int>> links;
+    for (const Edge& edge : g.edges) {
+        if (!edge.isColo) continue;
+        int arg = edge.source.isARG ? edge.source.id : edge.target.id;
+        int mge = edge.source.isARG ? edge.target.id : edge.source.id;
+        links.emplace_back(arg, mge);
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    BipartiteEdgeArray b;
+    for (const auto& [arg, mge] : links) {
+        if (b.argIds.empty() || b.argIds.back() != arg) b.argIds.push_back(arg);
+        b.mgeIds.push_back(mge);
+    }
+    std::sort(b.mgeIds.begin(), b.mgeIds.end());
+    b.mgeIds.erase(std::unique(b.mgeIds.begin(), b.mgeIds.end()), b.mgeIds.end());
+
+    std::unordered_map<int, int> column;
+    for (size_t c = 0; c < b.mgeIds.size(); ++c) column[b.mgeIds[c]] = static_cast<int>(c);
+
+    // Links are sorted by (ARG, MGE ID) and MGE codes follow IDs, so rows come out sorted
+    b.rowPtr.assign(b.argIds.size() + 1, 0);
+    b.cols.reserve(links.size());
+    size_t row = 0;
+    for (const auto& [arg, mge] : links) {
+        if (b.argIds[row] != arg) ++row;
+        b.rowPtr[row + 1]++;
+        b.cols.push_back(column.at(mge));
+    }
+    for (size_t r = 0; r < b.rows(); ++r) b.rowPtr[r + 1] += b.rowPtr[r];
+    return b;
+}
+
+
+void curveballRandomize(BipartiteEdgeArray& b, size_t trades, uint64_t seed) {
+    const size_t n = b.rows();
+    if (n < 2) return;
+
+    SplitMix64 rng{seed};
+    std::vector<int> shared, pool;
+    for (size_t t = 0; t < trades; ++t) {
+        const size_t x = rng.below(n);
+        size_t y = rng.below(n - 1);
+        if (y >= x) ++y;
+
+        int* a = b.cols.data() + b.rowPtr[x];
+        int* aEnd = b.cols.data() + b.rowPtr[x + 1];
+        int* c = b.cols.data() + b.rowPtr[y];
+        int* cEnd = b.cols.data() + b.rowPtr[y + 1];
+
+        // Split both rows into shared columns and a pool of columns held by only one of them
+        shared.clear();
+        pool.clear();
+        size_t onlyA = 0;
+        for (const int *i = a, *j = c; i < aEnd || j < cEnd;) {
+            if (j == cEnd || (i < aEnd && *i < *j)) { pool.push_back(*i++); ++onlyA; }
+            else if (i == aEnd || *j < *i) pool.push_back(*j++);
+            else { shared.push_back(*i); ++i; ++j; }
+        }
+        if (onlyA == 0 || onlyA == pool.size()) continue;
+
+        // Row x keeps onlyA columns drawn from the pool, row y gets the rest
+        for (size_t i = 0; i < onlyA; ++i) std::swap(pool[i], pool[i + rng.below(pool.size() - i)]);
+        std::sort(pool.begin(), pool.begin() + onlyA);
+        std::sort(pool.begin() + onlyA, pool.end());
+        std::merge(shared.begin(), shared.end(), pool.begin(), pool.begin() + onlyA, a);
+        std::merge(shared.begin(), shared.end(), pool.begin() + onlyA, pool.end(), c);
+    }
+}
+
+
+std::vector<NullModelStatistic> runDegreePreservingNullModel(const Graph& g, const NullModelOptions& options) {
+    const BipartiteEdgeArray observedArray = buildBipartiteEdgeArray(g);
+    const auto argPairs = topEntityPairs(g, true, options.topK, observedArray.argIds);
+    const auto mgePairs = topEntityPairs(g, false, options.topK, observedArray.mgeIds);
+
+    const std::vector<double> observed = measure(observedArray, argPairs, mgePairs);
+    const size_t S = observed.size();
+    const size_t R = options.replicates;
+    const size_t trades = options.tradesPerRow * observedArray.rows();
+
+    std::vector<double> samples(R * S);
+    parallelFor(R, [&](size_t r) {
+        BipartiteEdgeArray replicate = observedArray;
+        curveballRandomize(replicate, trades, SplitMix64::stream(options.seed, r).next());
+        const std::vector<double> values = measure(replicate, argPairs, mgePairs);
+        std::copy(values.begin(), values.end(), samples.begin() + r * S);
+    }, options.threads);
+
+    std::vector<NullModelStatistic> statistics;
+    statistics.push_back({"butterflies", "", "", 0, 0, 0, 0, 1});
+    statistics.push_back({"arg_cooccurrence_pairs", "", "", 0, 0, 0, 0, 1});
+    statistics.push_back({"mge_cooccurrence_pairs", "", "", 0, 0, 0, 0, 1});
+    for (const auto& [x, y] : argPairs)
+        statistics.push_back({"shared_mges", getARGName(observedArray.argIds[x]), getARGName(observedArray.argIds[y]), 0, 0, 0, 0, 1});
+    for (const auto& [x, y] : mgePairs)
+        statistics.push_back({"shared_args", getMGEName(observedArray.mgeIds[x]), getMGEName(observedArray.mgeIds[y]), 0, 0, 0, 0, 1});
+
+    for (size_t s = 0; s < S; ++s) {
+        double sum = 0, sumSq = 0;
+        size_t atLeast = 0;
+        for (size_t r = 0; r < R; ++r) {
+            const double v = samples[r * S + s];
+            sum += v;
+            sumSq += v * v;
+            atLeast += (v >= observed[s]);
+        }
+        NullModelStatistic& st = statistics[s];
+        st.observed = observed[s];
+        st.nullMean = R ? sum / R : 0.0;
+        st.nullSD = R > 1 ? std::sqrt(std::max(0.0, (sumSq - R * st.nullMean * st.nullMean) / (R - 1))) : 0.0;
+        st.zScore = st.nullSD > 0 ? (st.observed - st.nullMean) / st.nullSD : 0.0;
+        st.pValue = static_cast<double>(1 + atLeast) / static_cast<double>(1 + R);
+    }
+
+    std::cout << "Null model: " << R << " curveball replicates of " << observedArray.rows() << " ARGs x "
+              << observedArray.mgeIds.size() << " MGEs (" << observedArray.edges() << " links), butterflies z="
+              << statistics[0].zScore << "\n";
+    return statistics;
+}
+
+
+void writeNullModelCSV(const std::vector<NullModelStatistic>& statistics, const std::string& filename) {
+    CsvWriter csv(filename);
+    csv.header({"Statistic","EntityA","EntityB","Observed","NullMean","NullSD","ZScore","PValue"});
+    for (const NullModelStatistic& st : statistics)
+        csv.row(st.statistic, st.entityA, st.entityB, st.observed, st.nullMean, st.nullSD, st.zScore, st.pValue);
+    csv.close();
+}
@@ -0,0 +1,207 @@
+/* Configurable post-FMT window schemes compiled into ordinal lookup tables */
+#include "../include/post_windows.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+const char* const DONOR_COLOR = "yellow";
+const char* const PRE_COLOR = "red";
+const char* const UNBINNED_COLOR = "green";    // post-FMT days outside every window, unknown timepoints
+const char* const DEFAULT_WINDOW_COLORS[] = {"#99D2FF", "#4D9DFF", "#3A6EFF"};
+constexpr size_t DEFAULT_COLOR_STOPS = sizeof(DEFAULT_WINDOW_COLORS) / sizeof(DEFAULT_WINDOW_COLORS[0]);
+
+// Colour of window i of n on the light-to-dark ramp through the default colours (three windows get them exactly)
+std::string defaultWindowColor(size_t i, size_t n) {
+    const double t = n > 1 ? static_cast<double>(i) / static_cast<double>(n - 1) * (DEFAULT_COLOR_STOPS - 1) : 0.0;
+    const size_t stop = std::min(static_cast<size_t>(t), DEFAULT_COLOR_STOPS - 2);
+    const double f = t - static_cast<double>(stop);
+
+    unsigned a[3], b[3];
+    std::sscanf(DEFAULT_WINDOW_COLORS[stop], "#%02X%02X%02X", &a[0], &a[1], &a[2]);
+    std::sscanf(DEFAULT_WINDOW_COLORS[stop + 1], "#%02X%02X%02X", &b[0], &b[1], &b[2]);
+    char hex[8];
+    std::snprintf(hex, sizeof(hex), "#%02X%02X%02X",
+                  static_cast<unsigned>(std::lround(a[0] + (static_cast<double>(b[0]) - a[0]) * f)),
+                  static_cast<unsigned>(std::lround(a[1] + (static_cast<double>(b[1]) - a[1]) * f)),
+                  static_cast<unsigned>(std::lround(a[2] + (static_cast<double>(b[2]) - a[2]) * f)));
+    return hex;
+}
+
+PostWindowScheme& activeScheme() {
+    static PostWindowScheme scheme = standardPostWindows();
+    return scheme;
+}
+
+bool inWindow(int day, const PostWindow& w) {
+    return day >= w.fromDay && (w.toDay < 0 || day <= w.toDay);
+}
+
+} // namespace
+
+
+PostWindowScheme::PostWindowScheme(std::string name, std::vector<PostWindow> windows)
+    : name_(std::move(name)), windows_(std::move(windows)) {
+    if (windows_.empty() || windows_.size() > 255)
+        throw std::invalid_argument("Post-FMT window scheme '" + name_ + "' needs 1-255 windows");
+
+    std::sort(windows_.begin(), windows_.end(), [](const PostWindow& a, const PostWindow& b) { return a.fromDay < b.fromDay; });
+    for (size_t i = 0; i < windows_.size(); ++i) {
+        const PostWindow& w = windows_[i];
+        if (w.fromDay < 1 || (w.toDay >= 0 && w.toDay < w.fromDay))
+            throw std::invalid_argument("Post-FMT window '" + w.label + "' in scheme '" + name_ + "' has an invalid day range");
+        if (i + 1 < windows_.size() && (w.toDay < 0 || w.toDay >= windows_[i + 1].fromDay))
+            throw std::invalid_argument("Post-FMT windows '" + w.label + "' and '" + windows_[i + 1].label +
+                                        "' in scheme '" + name_ + "' overlap");
+        if (windows_[i].color.empty())
+            windows_[i].color = defaultWindowColor(i, windows_.size());
+    }
+
+    // Day of a post-FMT timepoint is its enum value
+    binByOrdinal_.assign(TIMEPOINT_COUNT, 0);
+    for (const TimepointTraits& t : TIMEPOINT_TRAITS) {
+        if (t.category != TimepointCategory::PostFMT) continue;
+        const int day = static_cast<int>(t.tp);
+        for (size_t i = 0; i < windows_.size(); ++i)
+            if (inWindow(day, windows_[i])) binByOrdinal_[t.ordinal] = static_cast<unsigned char>(i + 1);
+    }
+}
+
+
+int PostWindowScheme::latestBin(const std::set<Timepoint>& tps) const {
+    int bin = 0;
+    for (const Timepoint& tp : tps) bin = std::max(bin, binOf(tp));
+    return bin;
+}
+
+
+std::string PostWindowScheme::categoryName(Timepoint tp) const {
+    switch (traitsOf(tp).category) {
+        case TimepointCategory::Donor:   return "donor";
+        case TimepointCategory::PreFMT:  return "pre";
+        case TimepointCategory::PostFMT: break;
+        case TimepointCategory::Unknown: return "unknown";
+    }
+    const int bin = binOf(tp);
+    return bin ? windows_[bin - 1].label : "post";
+}
+
+
+std::string PostWindowScheme::color(Timepoint tp) const {
+    switch (traitsOf(tp).category) {
+        case TimepointCategory::Donor:   return DONOR_COLOR;
+        case TimepointCategory::PreFMT:  return PRE_COLOR;
+        case TimepointCategory::PostFMT: break;
+        case TimepointCategory::Unknown: return UNBINNED_COLOR;
+    }
+    const int bin = binOf(tp);
+    return bin ? windows_[bin - 1].color : UNBINNED_COLOR;
+}
+
+
+std::vector<TimepointCategoryInfo> PostWindowScheme::categories() const {
+    std::vector<TimepointCategoryInfo> list = {
+        {categoryName(Timepoint::Donor), "Donor", DONOR_COLOR},
+        {categoryName(Timepoint::PreFMT), "Pre-FMT", PRE_COLOR},
+    };
+    for (const PostWindow& w : windows_) {
+        const std::string days = std::to_string(w.fromDay) + (w.toDay < 0 ? "+" : "–" + std::to_string(w.toDay));
+        list.push_back({w.label, "Post-FMT (" + days + " d)", w.color});
+    }
+    for (const TimepointTraits& t : TIMEPOINT_TRAITS) {
+        if (t.category == TimepointCategory::PostFMT && binByOrdinal_[t.ordinal] == 0) {
+            list.push_back({"post", "Post-FMT (other days)", UNBINNED_COLOR});
+            break;
+        }
+    }
+    return list;
+}
+
+
+PostWindowScheme standardPostWindows() {
+    return PostWindowScheme("standard", {
+        {"post1", 1, 30, DEFAULT_WINDOW_COLORS[0]},
+        {"post2", 31, 60, DEFAULT_WINDOW_COLORS[1]},
+        {"post3", 61, -1, DEFAULT_WINDOW_COLORS[2]}
+    });
+}
+
+
+const PostWindowScheme& activePostWindows() {
+    return activeScheme();
+}
+
+
+void setActivePostWindows(PostWindowScheme scheme) {
+    activeScheme() = std::move(scheme);
+}
+
+
+PostWindowSet::PostWindowSet(std::vector<PostWindowScheme> schemes)
+    : schemes_(std::move(schemes)), maskByOrdinal_(TIMEPOINT_COUNT, 0) {
+    for (size_t s = 0; s < schemes_.size(); ++s)
+        for (size_t w = 0; w < schemes_[s].windows().size(); ++w)
+            bitOwner_.emplace_back(s, w);
+    if (bitOwner_.size() > 64)
+        throw std::invalid_argument("At most 64 post-FMT windows can be evaluated together");
+
+    for (const TimepointTraits& t : TIMEPOINT_TRAITS) {
+        for (size_t bit = 0; bit < bitOwner_.size(); ++bit) {
+            const auto [s, w] = bitOwner_[bit];
+            if (schemes_[s].binOf(t.tp) == static_cast<int>(w) + 1)
+                maskByOrdinal_[t.ordinal] |= uint64_t(1) << bit;
+        }
+    }
+}
+
+
+uint64_t PostWindowSet::mask(const std::set<Timepoint>& tps) const {
+    uint64_t m = 0;
+    for (const Timepoint& tp : tps) {
+        const int ordinal = ordinalOf(tp);
+        if (ordinal >= 0) m |= maskByOrdinal_[ordinal];
+    }
+    return m;
+}
+
+
+void writePostWindowSummaryCSV(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                               const std::map<int, std::string>& patientToDiseaseMap,
+                               const PostWindowSet& windowSet, const std::string& filename) {
+    // (window bit, disease) -> colocalizations and distinct patients
+    std::map<std::pair<size_t, std::string>, std::pair<long long, std::set<int>>> counts;
+
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        uint64_t m = windowSet.mask(tps);
+        if (!m) continue;
+        const int patientID = std::get<0>(key);
+        auto it = patientToDiseaseMap.find(patientID);
+        const std::string disease = it != patientToDiseaseMap.end() ? it->second : "Unknown";
+
+        for (size_t bit = 0; m; ++bit, m >>= 1) {
+            if (!(m & 1)) continue;
+            for (const std::string& group : {std::string("All"), disease}) {
+                auto& entry = counts[{bit, group}];
+                entry.first++;
+                entry.second.insert(patientID);
+            }
+        }
+    }
+
+    CsvWriter csv(filename);
+    csv.header({"Scheme","Window","FromDay","ToDay","Disease","Colocalizations","Patients"});
+    for (const auto& [bitGroup, entry] : counts) {
+        const auto [s, w] = windowSet.bitOwner(bitGroup.first);
+        const PostWindowScheme& scheme = windowSet.schemes()[s];
+        const PostWindow& window = scheme.windows()[w];
+        csv.field(scheme.name()).field(window.label).field(window.fromDay);
+        if (window.toDay < 0) csv.empty();
+        else csv.field(window.toDay);
+        csv.row(bitGroup.second, entry.first, entry.second.size());
+    }
+    csv.close();
+}
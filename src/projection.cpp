@@ -0,0 +1,244 @@
+/* Bipartite projections (ARG–ARG, MGE–MGE) computed as sparse matrix products */
+#include "../include/projection.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Builds a CSR 0/1 matrix from (row entity, column) pairs; columns are re-indexed densely
+SparseIncidence buildIncidence(std::vector<std::pair<int, int>>& entries, const std::unordered_map<int, int>& rowOf) {
+    SparseIncidence m;
+    m.rowEntity.resize(rowOf.size());
+    for (const auto& [entity, row] : rowOf) m.rowEntity[row] = entity;
+
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    m.rowPtr.assign(rowOf.size() + 1, 0);
+    m.colIdx.reserve(entries.size());
+    for (const auto& [row, col] : entries) {
+        m.rowPtr[row + 1]++;
+        m.colIdx.push_back(col);
+    }
+    std::partial_sum(m.rowPtr.begin(), m.rowPtr.end(), m.rowPtr.begin());
+    return m;
+}
+
+// Column-major view (transpose) of a CSR incidence matrix
+SparseIncidence transpose(const SparseIncidence& m, size_t cols) {
+    SparseIncidence t;
+    t.rowEntity.resize(cols);
+    std::iota(t.rowEntity.begin(), t.rowEntity.end(), 0);
+    t.rowPtr.assign(cols + 1, 0);
+    for (int c : m.colIdx) t.rowPtr[c + 1]++;
+    std::partial_sum(t.rowPtr.begin(), t.rowPtr.end(), t.rowPtr.begin());
+    t.colIdx.resize(m.colIdx.size());
+    std::vector<size_t> fill(t.rowPtr.begin(), t.rowPtr.end() - 1);
+    for (size_t r = 0; r < m.rows(); ++r)
+        for (size_t i = m.rowPtr[r]; i < m.rowPtr[r + 1]; ++i)
+            t.colIdx[fill[m.colIdx[i]]++] = static_cast<int>(r);
+    return t;
+}
+
+int intersectionSize(const SparseIncidence& m, size_t a, size_t b) {
+    size_t i = m.rowPtr[a], iEnd = m.rowPtr[a + 1];
+    size_t j = m.rowPtr[b], jEnd = m.rowPtr[b + 1];
+    int count = 0;
+    while (i < iEnd && j < jEnd) {
+        if (m.colIdx[i] < m.colIdx[j]) ++i;
+        else if (m.colIdx[i] > m.colIdx[j]) ++j;
+        else { ++count; ++i; ++j; }
+    }
+    return count;
+}
+
+
+// One patient carrying one colocalized (ARG, MGE) pair; a projection only needs these
+struct ColocEntry {
+    int arg;
+    int mge;
+    int patient;
+};
+
+// Colocalization entries of g, gathered in one scan of the edges (edges listed in both directions repeat)
+std::vector<ColocEntry> colocEntries(const Graph& g) {
+    std::vector<ColocEntry> entries;
+    for (const Edge& edge : g.edges) {
+        if (!edge.isColo) continue;
+        const int arg = edge.source.isARG ? edge.source.id : edge.target.id;
+        const int mge = edge.source.isARG ? edge.target.id : edge.source.id;
+        for (int patientID : edge.individuals) entries.push_back({arg, mge, patientID});
+    }
+    return entries;
+}
+
+// Entries of the patients with each disease
+std::map<std::string, std::vector<ColocEntry>> entriesByDisease(const std::vector<ColocEntry>& entries,
+                                                                const std::map<int, std::string>& patientToDiseaseMap) {
+    std::map<std::string, std::vector<ColocEntry>> byDisease;
+    for (const ColocEntry& e : entries) {
+        auto it = patientToDiseaseMap.find(e.patient);
+        if (it != patientToDiseaseMap.end()) byDisease[it->second].push_back(e);
+    }
+    return byDisease;
+}
+
+std::vector<ProjectionEdge> projectEntries(const std::vector<ColocEntry>& entries, const ProjectionOptions& options) {
+    // Incidence entries: side entity x partner entity, and side entity x patient
+    std::unordered_map<int, int> rowOf, partnerOf, patientOf;
+    std::vector<std::pair<int, int>> partnerEntries, patientEntries;
+    partnerEntries.reserve(entries.size());
+    patientEntries.reserve(entries.size());
+
+    for (const ColocEntry& e : entries) {
+        const int side = options.argSide ? e.arg : e.mge;
+        const int partner = options.argSide ? e.mge : e.arg;
+        const int row = rowOf.emplace(side, static_cast<int>(rowOf.size())).first->second;
+        partnerEntries.emplace_back(row, partnerOf.emplace(partner, static_cast<int>(partnerOf.size())).first->second);
+        patientEntries.emplace_back(row, patientOf.emplace(e.patient, static_cast<int>(patientOf.size())).first->second);
+    }
+
+    SparseIncidence B = buildIncidence(partnerEntries, rowOf);
+    SparseIncidence P = buildIncidence(patientEntries, rowOf);
+    SparseIncidence BT = transpose(B, partnerOf.size());
+
+    // Gustavson row-by-row product of B * B^T (upper triangle), one dense accumulator per thread;
+    // shared patients are only computed for pairs that pass the partner threshold
+    const size_t n = B.rows();
+    const size_t workers = workerCount(n, options.threads);
+    std::vector<std::vector<int>> accumulators(workers, std::vector<int>(n, 0));
+    std::vector<std::vector<int>> touchedLists(workers);
+    std::vector<std::vector<ProjectionEdge>> perThread(workers);
+
+    parallelForChunks(n, [&](size_t begin, size_t end, size_t t) {
+        auto& acc = accumulators[t];
+        auto& touched = touchedLists[t];
+        for (size_t row = begin; row < end; ++row) {
+            touched.clear();
+            for (size_t i = B.rowPtr[row]; i < B.rowPtr[row + 1]; ++i) {
+                int partner = B.colIdx[i];
+                for (size_t k = BT.rowPtr[partner]; k < BT.rowPtr[partner + 1]; ++k) {
+                    int other = BT.colIdx[k];
+                    if (static_cast<size_t>(other) <= row) continue;
+                    if (acc[other]++ == 0) touched.push_back(other);
+                }
+            }
+            for (int other : touched) {
+                int shared = acc[other];
+                acc[other] = 0;
+                if (shared < options.minSharedPartners) continue;
+                int patients = intersectionSize(P, row, other);
+                if (patients < options.minSharedPatients) continue;
+
+                int a = B.rowEntity[row], b = B.rowEntity[other];
+                if (a > b) std::swap(a, b);
+                perThread[t].push_back({a, b, shared, patients});
+            }
+        }
+    }, workers);
+
+    std::vector<ProjectionEdge> edges;
+    for (auto& part : perThread) edges.insert(edges.end(), part.begin(), part.end());
+    std::sort(edges.begin(), edges.end(), [](const ProjectionEdge& x, const ProjectionEdge& y) {
+        return std::tie(x.a, x.b) < std::tie(y.a, y.b);
+    });
+    return edges;
+}
+
+} // namespace
+
+
+std::vector<ProjectionEdge> projectBipartite(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                                             const ProjectionOptions& options) {
+    const std::vector<ColocEntry> entries = colocEntries(g);
+    if (options.disease.empty()) return projectEntries(entries, options);
+    return projectEntries(entriesByDisease(entries, patientToDiseaseMap)[options.disease], options);
+}
+
+
+CompactGraph projectionToCompact(const std::vector<ProjectionEdge>& edges, bool argSide) {
+    CompactGraph cg;
+    std::unordered_map<int, int> vertexOf;
+    auto vertex = [&](int id) {
+        auto [it, inserted] = vertexOf.emplace(id, static_cast<int>(cg.entityId.size()));
+        if (inserted) {
+            cg.entityId.push_back(id);
+            cg.isARG.push_back(argSide);
+        }
+        return it->second;
+    };
+    for (const auto& e : edges) {
+        vertex(e.a);
+        vertex(e.b);
+    }
+
+    const size_t n = cg.entityId.size();
+    cg.offsets.assign(n + 1, 0);
+    for (const auto& e : edges) {
+        cg.offsets[vertexOf[e.a] + 1]++;
+        cg.offsets[vertexOf[e.b] + 1]++;
+    }
+    std::partial_sum(cg.offsets.begin(), cg.offsets.end(), cg.offsets.begin());
+    cg.neighbors.resize(cg.offsets[n]);
+    cg.weights.resize(cg.offsets[n]);
+    std::vector<size_t> fill(cg.offsets.begin(), cg.offsets.end() - 1);
+    for (const auto& e : edges) {
+        int a = vertexOf[e.a], b = vertexOf[e.b];
+        cg.neighbors[fill[a]] = b;  cg.weights[fill[a]++] = e.sharedPartners;
+        cg.neighbors[fill[b]] = a;  cg.weights[fill[b]++] = e.sharedPartners;
+    }
+    return cg;
+}
+
+
+void writeProjectionCSV(const std::vector<ProjectionEdge>& edges, bool argSide, const std::string& filename) {
+    CsvWriter csv(filename);
+    if (argSide)
+        csv.header({"ARG_A","ARG_B","SharedMGEs","SharedPatients"});
+    else
+        csv.header({"MGE_A","MGE_B","SharedARGs","SharedPatients"});
+    for (const auto& e : edges) {
+        csv.row(argSide ? getARGName(e.a) : getMGEName(e.a),
+                argSide ? getARGName(e.b) : getMGEName(e.b),
+                e.sharedPartners, e.sharedPatients);
+    }
+    csv.close();
+}
+
+
+void writeAllProjections(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap,
+                         const std::string& outputDir, int minSharedPartners, int minSharedPatients) {
+    // One scan of the graph; each disease then projects only its own patients' entries
+    const std::vector<ColocEntry> entries = colocEntries(g);
+    const auto byDisease = entriesByDisease(entries, patientToDiseaseMap);
+    std::set<std::string> diseases;
+    for (const auto& [patientID, disease] : patientToDiseaseMap) diseases.insert(disease);
+    const std::vector<ColocEntry> none;
+
+    for (bool argSide : {true, false}) {
+        const std::string prefix = outputDir + (argSide ? "/arg_arg" : "/mge_mge");
+
+        ProjectionOptions options;
+        options.argSide = argSide;
+        options.minSharedPartners = minSharedPartners;
+        options.minSharedPatients = minSharedPatients;
+
+        auto edges = projectEntries(entries, options);
+        writeProjectionCSV(edges, argSide, prefix + ".csv");
+        std::cout << "Projection (" << (argSide ? "ARG-ARG" : "MGE-MGE") << "): " << edges.size() << " edges\n";
+
+        for (const auto& disease : diseases) {
+            auto it = byDisease.find(disease);
+            auto diseaseEdges = projectEntries(it != byDisease.end() ? it->second : none, options);
+            writeProjectionCSV(diseaseEdges, argSide, prefix + "_" + sanitizeFileName(disease) + ".csv");
+        }
+    }
+}
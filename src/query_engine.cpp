@@ -0,0 +1,416 @@
+/* Predicate query engine: posting-list indexes per field, most selective index first, fused filter scan */
+#include "../include/query_engine.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/post_windows.h"
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+const char* const FIELD_NAMES[] = {"arg", "mge", "mge_group", "arg_group", "disease", "patient", "timepoint"};
+
+const char* fieldName(QueryField f) { return FIELD_NAMES[static_cast<size_t>(f)]; }
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+struct Token {
+    enum Kind { Word, Quoted, Symbol, End } kind;
+    std::string text;
+    size_t pos;
+};
+
+std::vector<Token> tokenize(const std::string& text) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        const char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) { ++i; continue; }
+        if (c == '(' || c == ')' || c == ',' || c == '=') {
+            tokens.push_back({Token::Symbol, std::string(1, c), i});
+            ++i;
+        } else if (c == '!' && i + 1 < text.size() && text[i + 1] == '=') {
+            tokens.push_back({Token::Symbol, "!=", i});
+            i += 2;
+        } else if (c == '"') {
+            const size_t close = text.find('"', i + 1);
+            if (close == std::string::npos)
+                throw std::invalid_argument("Query: unterminated string at position " + std::to_string(i));
+            tokens.push_back({Token::Quoted, text.substr(i + 1, close - i - 1), i});
+            i = close + 1;
+        } else {
+            const size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+                   std::string("()=,!\"").find(text[i]) == std::string::npos) ++i;
+            if (i == start)
+                throw std::invalid_argument("Query: unexpected '" + std::string(1, c) + "' at position " + std::to_string(i));
+            tokens.push_back({Token::Word, text.substr(start, i - start), start});
+        }
+    }
+    tokens.push_back({Token::End, "", text.size()});
+    return tokens;
+}
+
+[[noreturn]] void syntaxError(const Token& t, const std::string& expected) {
+    const std::string found = t.kind == Token::End ? "end of query" : "'" + t.text + "'";
+    throw std::invalid_argument("Query: expected " + expected + " at position " + std::to_string(t.pos) + ", found " + found);
+}
+
+bool isKeyword(const Token& t, const char* keyword) {
+    return t.kind == Token::Word && lower(t.text) == keyword;
+}
+
+} // namespace
+
+
+std::vector<QueryPredicate> parseQuery(const std::string& text) {
+    const std::vector<Token> tokens = tokenize(text);
+    std::vector<QueryPredicate> predicates;
+    size_t i = 0;
+
+    auto value = [&]() {
+        const Token& t = tokens[i];
+        if (t.kind != Token::Word && t.kind != Token::Quoted) syntaxError(t, "a value");
+        ++i;
+        return t.text;
+    };
+
+    while (tokens[i].kind != Token::End) {
+        if (!predicates.empty()) {
+            if (!isKeyword(tokens[i], "and")) syntaxError(tokens[i], "'and'");
+            ++i;
+        }
+
+        const Token& f = tokens[i];
+        if (f.kind != Token::Word) syntaxError(f, "a field name");
+        const auto name = std::find(std::begin(FIELD_NAMES), std::end(FIELD_NAMES), lower(f.text));
+        if (name == std::end(FIELD_NAMES)) syntaxError(f, "one of arg, mge, mge_group, arg_group, disease, patient, timepoint");
+        ++i;
+
+        QueryPredicate p;
+        p.field = static_cast<QueryField>(name - std::begin(FIELD_NAMES));
+
+        const Token& op = tokens[i];
+        if (op.kind == Token::Symbol && (op.text == "=" || op.text == "!=")) {
+            p.negated = op.text == "!=";
+            ++i;
+            p.values.push_back(value());
+        } else if (isKeyword(op, "in") || isKeyword(op, "not")) {
+            if (isKeyword(op, "not")) {
+                p.negated = true;
+                if (!isKeyword(tokens[++i], "in")) syntaxError(tokens[i], "'in'");
+            }
+            if (tokens[++i].text != "(" || tokens[i].kind != Token::Symbol) syntaxError(tokens[i], "'('");
+            ++i;
+            p.values.push_back(value());
+            while (tokens[i].kind == Token::Symbol && tokens[i].text == ",") {
+                ++i;
+                p.values.push_back(value());
+            }
+            if (tokens[i].kind != Token::Symbol || tokens[i].text != ")") syntaxError(tokens[i], "',' or ')'");
+            ++i;
+        } else {
+            syntaxError(op, "'=', '!=', 'in' or 'not in'");
+        }
+        predicates.push_back(std::move(p));
+    }
+    return predicates;
+}
+
+
+std::string QueryPlan::explain() const {
+    std::ostringstream os;
+    auto describe = [&](size_t p) {
+        const QueryPredicate& q = predicates[p];
+        os << fieldName(q.field) << (q.negated ? " not in (" : " in (");
+        for (size_t v = 0; v < q.values.size(); ++v) os << (v ? ", " : "") << q.values[v];
+        os << ")";
+    };
+
+    if (indexPredicate < 0) os << "full scan (" << estimatedRows << " records)";
+    else {
+        os << "index scan on ";
+        describe(static_cast<size_t>(indexPredicate));
+        os << " (" << estimatedRows << " records)";
+    }
+    if (!fused.empty()) {
+        os << " -> fused filter [";
+        for (size_t k = 0; k < fused.size(); ++k) {
+            if (k) os << " and ";
+            describe(fused[k]);
+        }
+        os << "]";
+    }
+    return os.str();
+}
+
+
+QueryIndex::QueryIndex(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap) : fields_(FIELDS) {
+    for (const Edge& edge : g.edges) {
+        if (!edge.isColo) continue;
+        const Node& arg = edge.source.isARG ? edge.source : edge.target;
+        const Node& mge = edge.source.isARG ? edge.target : edge.source;
+        if (ordinalOf(arg.timepoint) < 0) continue;   // unknown timepoints are never matched
+        for (int patientID : edge.individuals)
+            records_.push_back({patientID, arg.id, mge.id, arg.timepoint, &edge});
+    }
+    for (const Edge& edge : g.edges) {
+        edgesOf_[edge.source].push_back(&edge);
+        if (!(edge.target == edge.source)) edgesOf_[edge.target].push_back(&edge);
+    }
+
+    // Timepoint codes are ordinals, so every timepoint has a slot even when absent from the data
+    FieldIndex& tpField = fields_[static_cast<size_t>(QueryField::Timepoint)];
+    for (const TimepointTraits& t : TIMEPOINT_TRAITS) tpField.labels.push_back(t.name);
+    tpField.postings.resize(TIMEPOINT_COUNT);
+
+    // Label of each record per field; dictionary fields share one code per distinct label
+    std::vector<std::unordered_map<std::string, int>> codeOfLabel(FIELDS);
+    auto labelOf = [&](QueryField f, const ColocRecord& r) -> std::string {
+        switch (f) {
+            case QueryField::ARG:      return getARGName(r.arg);
+            case QueryField::MGE:      return getMGEName(r.mge);
+            case QueryField::MGEGroup: return getMGEGroupName(r.mge);
+            case QueryField::ARGGroup: return getARGGroupName(r.arg);
+            case QueryField::Disease: {
+                auto it = patientToDiseaseMap.find(r.patient);
+                return it != patientToDiseaseMap.end() ? it->second : "Unknown";
+            }
+            case QueryField::Patient:  return std::to_string(r.patient);
+            default:                   return toString(r.timepoint);
+        }
+    };
+
+    for (size_t f = 0; f < FIELDS; ++f) {
+        FieldIndex& index = fields_[f];
+        index.column.resize(records_.size());
+        // Names are resolved once per distinct entity / patient, not per record
+        std::unordered_map<int, int> codeOfKey;
+
+        for (size_t r = 0; r < records_.size(); ++r) {
+            const ColocRecord& rec = records_[r];
+            const QueryField field = static_cast<QueryField>(f);
+            int code;
+            if (field == QueryField::Timepoint) {
+                code = ordinalOf(rec.timepoint);
+            } else {
+                const int key = (field == QueryField::ARG || field == QueryField::ARGGroup) ? rec.arg
+                              : (field == QueryField::MGE || field == QueryField::MGEGroup) ? rec.mge
+                              : rec.patient;
+                auto known = codeOfKey.find(key);
+                if (known != codeOfKey.end()) code = known->second;
+                else {
+                    const std::string label = labelOf(field, rec);
+                    auto it = codeOfLabel[f].find(label);
+                    if (it == codeOfLabel[f].end()) {
+                        it = codeOfLabel[f].emplace(label, static_cast<int>(index.labels.size())).first;
+                        index.labels.push_back(label);
+                        index.postings.emplace_back();
+                    }
+                    code = it->second;
+                    codeOfKey[key] = code;
+                }
+            }
+            index.column[r] = code;
+            index.postings[code].push_back(static_cast<uint32_t>(r));
+        }
+        for (size_t c = 0; c < index.labels.size(); ++c) index.codes[index.labels[c]].push_back(static_cast<int>(c));
+    }
+}
+
+
+const std::string& QueryIndex::label(QueryField f, size_t record) const {
+    const FieldIndex& index = field(f);
+    return index.labels[index.column[record]];
+}
+
+
+const std::vector<const Edge*>& QueryIndex::edgesOf(const Node& node) const {
+    static const std::vector<const Edge*> none;
+    auto it = edgesOf_.find(node);
+    return it != edgesOf_.end() ? it->second : none;
+}
+
+
+std::vector<char> QueryIndex::allowedCodes(const QueryPredicate& predicate) const {
+    const FieldIndex& index = field(predicate.field);
+    std::vector<char> allowed(index.labels.size(), 0);
+
+    for (const std::string& value : predicate.values) {
+        bool matched = false;
+        if (predicate.field == QueryField::Timepoint) {
+            // Category, window of the active scheme, or exact timepoint name
+            const std::string v = lower(value);
+            const PostWindowScheme& windows = activePostWindows();
+            for (const TimepointTraits& t : TIMEPOINT_TRAITS) {
+                const bool hit = (v == "donor" && t.category == TimepointCategory::Donor) ||
+                                 (v == "pre" && t.category == TimepointCategory::PreFMT) ||
+                                 (v == "post" && t.category == TimepointCategory::PostFMT) ||
+                                 (t.category == TimepointCategory::PostFMT && windows.categoryName(t.tp) == value) ||
+                                 v == t.name;
+                if (hit) allowed[t.ordinal] = matched = true;
+            }
+        } else {
+            auto it = index.codes.find(value);
+            if (it != index.codes.end()) {
+                for (int code : it->second) allowed[code] = 1;
+                matched = true;
+            }
+        }
+        if (!matched)
+            throw std::invalid_argument(std::string("Query: no ") + fieldName(predicate.field) + " named '" + value + "' in the data");
+    }
+
+    if (predicate.negated)
+        for (char& a : allowed) a = !a;
+    return allowed;
+}
+
+
+QueryPlan QueryIndex::compile(std::vector<QueryPredicate> predicates) const {
+    QueryPlan plan;
+    plan.predicates = std::move(predicates);
+
+    // Rows each predicate's posting lists would hand to the scan
+    std::vector<size_t> cost;
+    for (const QueryPredicate& p : plan.predicates) {
+        plan.allowed.push_back(allowedCodes(p));
+        const FieldIndex& index = field(p.field);
+        size_t rows = 0;
+        for (size_t c = 0; c < index.postings.size(); ++c)
+            if (plan.allowed.back()[c]) rows += index.postings[c].size();
+        cost.push_back(rows);
+    }
+
+    std::vector<size_t> order(plan.predicates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cost[a] < cost[b]; });
+
+    // Posting lists only pay off when they skip most records; otherwise scan everything
+    plan.estimatedRows = records_.size();
+    if (!order.empty() && cost[order.front()] < records_.size() / 2) {
+        plan.indexPredicate = static_cast<int>(order.front());
+        plan.estimatedRows = cost[order.front()];
+        order.erase(order.begin());
+    }
+    plan.fused = order;
+    return plan;
+}
+
+
+QueryResult QueryIndex::execute(const QueryPlan& plan) const {
+    QueryResult result;
+    result.plan = plan;
+
+    // Fused filter: every remaining predicate is a lookup in its allowed-code table
+    std::vector<std::pair<const std::vector<int>*, const std::vector<char>*>> checks;
+    for (size_t p : plan.fused) checks.emplace_back(&field(plan.predicates[p].field).column, &plan.allowed[p]);
+    auto passes = [&](uint32_t r) {
+        for (const auto& [column, allowed] : checks)
+            if (!(*allowed)[(*column)[r]]) return false;
+        return true;
+    };
+
+    if (plan.indexPredicate < 0) {
+        for (uint32_t r = 0; r < records_.size(); ++r)
+            if (passes(r)) result.records.push_back(r);
+        return result;
+    }
+
+    const QueryPredicate& indexed = plan.predicates[plan.indexPredicate];
+    const FieldIndex& index = field(indexed.field);
+    const std::vector<char>& allowed = plan.allowed[plan.indexPredicate];
+    // Every record has one code per field, so the posting lists are disjoint: gather them all, sort once
+    std::vector<uint32_t> candidates;
+    candidates.reserve(plan.estimatedRows);
+    size_t lists = 0;
+    for (size_t c = 0; c < index.postings.size(); ++c) {
+        if (!allowed[c]) continue;
+        candidates.insert(candidates.end(), index.postings[c].begin(), index.postings[c].end());
+        ++lists;
+    }
+    if (lists > 1) std::sort(candidates.begin(), candidates.end());
+    for (uint32_t r : candidates)
+        if (passes(r)) result.records.push_back(r);
+    return result;
+}
+
+
+Graph querySubgraph(const QueryIndex& index, const QueryResult& result, bool induced) {
+    Graph subgraph;
+    std::unordered_set<const Edge*> seen;
+    for (uint32_t r : result.records) {
+        const Edge* edge = index.record(r).edge;
+        if (!seen.insert(edge).second) continue;
+        subgraph.edges.insert(*edge);
+        subgraph.nodes.insert(edge->source);
+        subgraph.nodes.insert(edge->target);
+    }
+
+    // Edges that connect the collected nodes, looked up per node instead of scanning the graph
+    for (const Node& node : subgraph.nodes) {
+        for (const Edge* edge : index.edgesOf(node)) {
+            if (edge->isColo && !induced) continue;
+            if (subgraph.nodes.count(edge->source) && subgraph.nodes.count(edge->target)) subgraph.edges.insert(*edge);
+        }
+    }
+    return subgraph;
+}
+
+
+namespace {
+
+std::vector<std::vector<std::string>> resultRows(const QueryIndex& index, const QueryResult& result, size_t limit) {
+    std::vector<std::vector<std::string>> rows;
+    for (uint32_t r : result.records) {
+        if (limit && rows.size() >= limit) break;
+        rows.push_back({
+            index.label(QueryField::Patient, r),
+            index.label(QueryField::Disease, r),
+            index.label(QueryField::ARG, r),
+            index.label(QueryField::ARGGroup, r),
+            index.label(QueryField::MGE, r),
+            index.label(QueryField::MGEGroup, r),
+            toString(index.record(r).timepoint)
+        });
+    }
+    return rows;
+}
+
+const std::vector<std::string> RESULT_HEADER = {"Patient","Disease","ARG_Name","ARG_Group","MGE_Name","MGE_Group","Timepoint"};
+
+} // namespace
+
+
+void writeQueryResultCSV(const QueryIndex& index, const QueryResult& result, const std::string& filename) {
+    CsvWriter csv(filename, false, {1 << 20, true});   // large results: format while the previous block is written
+    csv.headerFrom(RESULT_HEADER);
+    for (uint32_t r : result.records) {
+        csv.row(index.label(QueryField::Patient, r), index.label(QueryField::Disease, r),
+                index.label(QueryField::ARG, r), index.label(QueryField::ARGGroup, r),
+                index.label(QueryField::MGE, r), index.label(QueryField::MGEGroup, r),
+                toString(index.record(r).timepoint));
+    }
+    csv.close();
+}
+
+
+void printQueryResult(const QueryIndex& index, const QueryResult& result, std::ostream& os, size_t limit) {
+    os << "Plan: " << result.plan.explain() << "\n";
+    os << "Matches: " << result.records.size() << " of " << index.size() << " records\n";
+    for (size_t c = 0; c < RESULT_HEADER.size(); ++c) os << (c ? "," : "") << RESULT_HEADER[c];
+    os << "\n";
+    for (const auto& row : resultRows(index, result, limit)) {
+        for (size_t c = 0; c < row.size(); ++c) os << (c ? "," : "") << row[c];
+        os << "\n";
+    }
+    if (limit && result.records.size() > limit) os << "... (" << result.records.size() - limit << " more)\n";
+}
@@ -0,0 +1,321 @@
+/* Resident server mode: answers viz queries from an in-memory indexed graph over HTTP */
+#include "../include/server.h"
+#include "../include/export_graph_json.h"
+#include "../include/parallel.h"
+#include "../external/json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <csignal>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using nlohmann::json;
+
+namespace {
+
+constexpr size_t MAX_REQUEST_BYTES = 16 * 1024;
+constexpr int RECEIVE_TIMEOUT_SECONDS = 10;   // idle clients give their worker back after this
+
+// Responses echo request text, which need not be valid UTF-8; replace bad bytes instead of throwing
+std::string dumpBody(const json& body) {
+    return body.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+std::string urlDecode(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') out += ' ';
+        else if (s[i] == '%' && i + 2 < s.size() && std::isxdigit(static_cast<unsigned char>(s[i + 1])) &&
+                 std::isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+            out += static_cast<char>(std::strtol(s.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else out += s[i];
+    }
+    return out;
+}
+
+std::map<std::string, std::string> parseParams(const std::string& queryString) {
+    std::map<std::string, std::string> params;
+    size_t start = 0;
+    while (start <= queryString.size()) {
+        size_t end = queryString.find('&', start);
+        if (end == std::string::npos) end = queryString.size();
+        const std::string pair = queryString.substr(start, end - start);
+        if (!pair.empty()) {
+            const size_t eq = pair.find('=');
+            params[urlDecode(pair.substr(0, eq))] = eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+        }
+        start = end + 1;
+    }
+    return params;
+}
+
+ServiceResponse error(int status, const std::string& message) {
+    return {status, dumpBody(json{{"error", message}})};
+}
+
+std::string param(const std::map<std::string, std::string>& params, const std::string& key, const std::string& fallback = "") {
+    auto it = params.find(key);
+    return it != params.end() ? it->second : fallback;
+}
+
+} // namespace
+
+
+GraphService::GraphService(const Graph& g, const std::map<int, std::string>& patientToDiseaseMap, const CommunityMap& communities)
+    : patientToDiseaseMap_(patientToDiseaseMap), communities_(communities), index_(g, patientToDiseaseMap) {}
+
+
+ServiceResponse GraphService::handle(const std::string& target) const {
+    const size_t q = target.find('?');
+    const std::string path = target.substr(0, q);
+    const auto params = parseParams(q == std::string::npos ? "" : target.substr(q + 1));
+
+    try {
+        if (path == "/health") return {200, dumpBody(json{{"status", "ok"}, {"records", index_.size()}})};
+        if (path == "/query") return query(params);
+        if (path == "/subgraph") return subgraph(params);
+        if (path == "/timeline") return timeline(params);
+    } catch (const std::invalid_argument& e) {
+        return error(400, e.what());
+    } catch (const std::exception& e) {
+        // Anything else is our fault, but one request must not take the server down
+        return error(500, std::string("Internal error: ") + e.what());
+    }
+    return error(404, "Unknown endpoint: " + path);
+}
+
+
+ServiceResponse GraphService::query(const std::map<std::string, std::string>& params) const {
+    const QueryResult result = index_.run(param(params, "q"));
+    const size_t limit = std::strtoul(param(params, "limit", "1000").c_str(), nullptr, 10);
+
+    json records = json::array();
+    for (uint32_t r : result.records) {
+        if (limit && records.size() >= limit) break;
+        records.push_back({
+            {"patient",   index_.record(r).patient},
+            {"disease",   index_.label(QueryField::Disease, r)},
+            {"arg",       index_.label(QueryField::ARG, r)},
+            {"argGroup",  index_.label(QueryField::ARGGroup, r)},
+            {"mge",       index_.label(QueryField::MGE, r)},
+            {"mgeGroup",  index_.label(QueryField::MGEGroup, r)},
+            {"timepoint", index_.label(QueryField::Timepoint, r)}
+        });
+    }
+    return {200, dumpBody(json{{"plan", result.plan.explain()}, {"matches", result.records.size()}, {"records", records}})};
+}
+
+
+ServiceResponse GraphService::subgraph(const std::map<std::string, std::string>& params) const {
+    const QueryResult result = index_.run(param(params, "q"));
+    const Graph slice = querySubgraph(index_, result, param(params, "induced") == "1");
+    std::string body;
+    JsonWriter out(&body);
+    writeGraphJsonSimple(out, slice, patientToDiseaseMap_, communities_);
+    return {200, body};
+}
+
+
+ServiceResponse GraphService::timeline(const std::map<std::string, std::string>& params) const {
+    const bool isARG = params.count("arg") > 0;
+    if (!isARG && !params.count("mge")) return error(400, "timeline needs an arg or mge parameter");
+    const std::string name = param(params, isARG ? "arg" : "mge");
+
+    QueryPredicate predicate{isARG ? QueryField::ARG : QueryField::MGE, false, {name}};
+    const QueryResult result = index_.execute(index_.compile({predicate}));
+
+    // Partner -> timepoint ordinals and patients
+    std::map<std::string, std::pair<std::set<int>, std::set<int>>> partners;
+    std::set<int> patients;
+    for (uint32_t r : result.records) {
+        const ColocRecord& rec = index_.record(r);
+        auto& partner = partners[index_.label(isARG ? QueryField::MGE : QueryField::ARG, r)];
+        partner.first.insert(ordinalOf(rec.timepoint));
+        partner.second.insert(rec.patient);
+        patients.insert(rec.patient);
+    }
+
+    json list = json::array();
+    for (const auto& [partnerName, seen] : partners) {
+        json timepoints = json::array();
+        for (int ordinal : seen.first) timepoints.push_back(TIMEPOINT_TRAITS[ordinal].name);
+        list.push_back({{"name", partnerName}, {"timepoints", timepoints}, {"patients", seen.second.size()}});
+    }
+    return {200, dumpBody(json{{"entity", name}, {"isARG", isARG}, {"patients", patients.size()}, {"partners", list}})};
+}
+
+
+#ifdef _WIN32
+
+int serveGraph(const GraphService&, const ServeOptions&) {
+    std::cerr << "Server mode needs POSIX sockets and is not available on Windows\n";
+    return 1;
+}
+
+#else
+
+namespace {
+
+// Listener the stop signal shuts down; shutdown() is async-signal-safe and wakes every worker in accept()
+volatile std::sig_atomic_t stopListener = -1;
+volatile std::sig_atomic_t stopRequested = 0;
+
+extern "C" void requestStop(int) {
+    stopRequested = 1;
+    if (stopListener >= 0) ::shutdown(stopListener, SHUT_RDWR);
+}
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        default:  return "Internal Server Error";
+    }
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void handleConnection(int fd, const GraphService& service) {
+    timeval timeout{};
+    timeout.tv_sec = RECEIVE_TIMEOUT_SECONDS;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return;
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    // Request line: METHOD TARGET VERSION
+    const size_t lineEnd = request.find("\r\n");
+    const std::string line = request.substr(0, lineEnd);
+    const size_t s1 = line.find(' ');
+    const size_t s2 = line.find(' ', s1 + 1);
+
+    ServiceResponse response;
+    if (s1 == std::string::npos || s2 == std::string::npos) response = error(400, "Malformed request line");
+    else if (line.substr(0, s1) != "GET") response = error(405, "Only GET is supported");
+    else response = service.handle(line.substr(s1 + 1, s2 - s1 - 1));
+
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " + statusText(response.status) + "\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Connection: close\r\n"
+                       "Content-Length: " + std::to_string(response.body.size()) + "\r\n\r\n";
+    if (sendAll(fd, head)) sendAll(fd, response.body);
+}
+
+int openListener(const ServeOptions& options, std::string& address) {
+    int fd;
+    if (!options.unixSocket.empty()) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (options.unixSocket.size() >= sizeof(addr.sun_path)) { ::close(fd); return -1; }
+        std::strncpy(addr.sun_path, options.unixSocket.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(options.unixSocket.c_str());
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) { ::close(fd); return -1; }
+        address = "unix:" + options.unixSocket;
+    } else {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int reuse = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options.port));
+        if (::inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1) { ::close(fd); return -1; }
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) { ::close(fd); return -1; }
+        address = "http://" + options.host + ":" + std::to_string(options.port);
+    }
+    if (::listen(fd, 64) < 0) { ::close(fd); return -1; }
+    return fd;
+}
+
+} // namespace
+
+
+int serveGraph(const GraphService& service, const ServeOptions& options) {
+    std::signal(SIGPIPE, SIG_IGN);   // a client closing early must not kill the server
+
+    std::string address;
+    const int listener = openListener(options, address);
+    if (listener < 0) {
+        std::cerr << "Cannot listen on " << (options.unixSocket.empty() ? options.host + ":" + std::to_string(options.port)
+                                                                       : options.unixSocket)
+                  << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // SIGINT/SIGTERM shut the listener down; workers finish their connection and return
+    stopListener = listener;
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    // Every worker blocks in accept() on the shared listener; the kernel hands each connection to one of them
+    const size_t workers = options.threads ? options.threads : defaultThreadCount();
+    std::cout << "Serving on " << address << " with " << workers << " workers\n" << std::flush;
+
+    auto worker = [&]() {
+        while (!stopRequested) {
+            const int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (!stopRequested && (errno == EINTR || errno == ECONNABORTED)) continue;
+                return;
+            }
+            try {
+                handleConnection(client, service);
+            } catch (const std::exception& e) {
+                std::cerr << "[serveGraph] Dropped connection: " << e.what() << "\n";
+            }
+            ::close(client);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < workers; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    stopListener = -1;
+    ::close(listener);
+    if (!options.unixSocket.empty()) ::unlink(options.unixSocket.c_str());
+    if (!stopRequested) {
+        std::cerr << "Stopped accepting connections on " << address << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cout << "Server stopped\n";
+    return 0;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/* All-pairs patient similarity over bitset colocalization profiles */
+#include "../include/similarity.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t TILE = 32;          // patients per tile side
+constexpr size_t WORD_BLOCK = 256;   // 64-bit words per pass (2 KiB per row slice)
+
+bool inCategory(const Timepoint& tp, const std::string& category) {
+    if (category.empty()) return true;
+    if (category == "donor") return isDonor(tp);
+    if (category == "pre") return isPreFMT(tp);
+    if (category == "post") return isPostFMT(tp);
+    return false;
+}
+
+// |a AND b| over len words; four independent accumulators keep the popcount units busy
+int intersectionCount(const uint64_t* a, const uint64_t* b, size_t len) {
+    int c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t w = 0;
+    for (; w + 4 <= len; w += 4) {
+        c0 += popcount64(a[w] & b[w]);
+        c1 += popcount64(a[w + 1] & b[w + 1]);
+        c2 += popcount64(a[w + 2] & b[w + 2]);
+        c3 += popcount64(a[w + 3] & b[w + 3]);
+    }
+    for (; w < len; ++w) c0 += popcount64(a[w] & b[w]);
+    return c0 + c1 + c2 + c3;
+}
+
+double similarity(int inter, int ca, int cb, SimilarityMetric metric) {
+    if (metric == SimilarityMetric::Cosine) {
+        return (ca == 0 || cb == 0) ? 0.0 : inter / std::sqrt(static_cast<double>(ca) * cb);
+    }
+    int unionSize = ca + cb - inter;
+    return unionSize == 0 ? 0.0 : static_cast<double>(inter) / unionSize;
+}
+
+} // namespace
+
+
+PatientProfiles buildPatientProfiles(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                     const std::string& timepointCategory) {
+    PatientProfiles profiles;
+    std::map<std::pair<int, int>, int> pairColumn;
+    std::set<int> patients;
+
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        if (!std::any_of(tps.begin(), tps.end(), [&](const Timepoint& tp) { return inCategory(tp, timepointCategory); }))
+            continue;
+        const auto& [patientID, argID, mgeID] = key;
+        patients.insert(patientID);
+        pairColumn.emplace(std::make_pair(argID, mgeID), 0);
+    }
+
+    int column = 0;
+    for (auto& [pair, col] : pairColumn) {
+        col = column++;
+        profiles.pairs.push_back(pair);
+    }
+    profiles.patients.assign(patients.begin(), patients.end());
+
+    std::unordered_map<int, size_t> rowOf;
+    for (size_t i = 0; i < profiles.patients.size(); ++i) rowOf[profiles.patients[i]] = i;
+
+    profiles.words = (profiles.pairs.size() + 63) / 64;
+    profiles.bits.assign(profiles.patients.size() * profiles.words, 0);
+    profiles.cardinality.assign(profiles.patients.size(), 0);
+
+    for (const auto& [key, tps] : colocalizationByIndividual) {
+        if (!std::any_of(tps.begin(), tps.end(), [&](const Timepoint& tp) { return inCategory(tp, timepointCategory); }))
+            continue;
+        const auto& [patientID, argID, mgeID] = key;
+        size_t row = rowOf[patientID];
+        size_t col = pairColumn[{argID, mgeID}];
+        uint64_t& word = profiles.bits[row * profiles.words + col / 64];
+        uint64_t mask = uint64_t(1) << (col % 64);
+        if (!(word & mask)) {
+            word |= mask;
+            profiles.cardinality[row]++;
+        }
+    }
+    return profiles;
+}
+
+
+std::vector<int> computeIntersectionMatrix(const PatientProfiles& profiles, size_t threads) {
+    const size_t n = profiles.patients.size();
+    std::vector<int> matrix(n * n, 0);
+    if (n == 0) return matrix;
+
+    // Upper-triangular tile pairs, processed independently
+    const size_t tiles = (n + TILE - 1) / TILE;
+    std::vector<std::pair<size_t, size_t>> tilePairs;
+    for (size_t ti = 0; ti < tiles; ++ti)
+        for (size_t tj = ti; tj < tiles; ++tj) tilePairs.emplace_back(ti, tj);
+
+    parallelFor(tilePairs.size(), [&](size_t t) {
+        const auto [ti, tj] = tilePairs[t];
+        const size_t iBegin = ti * TILE, iEnd = std::min(n, iBegin + TILE);
+        const size_t jBegin = tj * TILE, jEnd = std::min(n, jBegin + TILE);
+
+        int inter[TILE][TILE] = {};
+        for (size_t w = 0; w < profiles.words; w += WORD_BLOCK) {
+            const size_t len = std::min(WORD_BLOCK, profiles.words - w);
+            for (size_t i = iBegin; i < iEnd; ++i) {
+                const uint64_t* a = profiles.row(i) + w;
+                for (size_t j = std::max(jBegin, i); j < jEnd; ++j)
+                    inter[i - iBegin][j - jBegin] += intersectionCount(a, profiles.row(j) + w, len);
+            }
+        }
+
+        for (size_t i = iBegin; i < iEnd; ++i) {
+            for (size_t j = std::max(jBegin, i); j < jEnd; ++j) {
+                matrix[i * n + j] = inter[i - iBegin][j - jBegin];
+                matrix[j * n + i] = inter[i - iBegin][j - jBegin];
+            }
+        }
+    }, threads);
+
+    return matrix;
+}
+
+
+std::vector<double> similarityFromIntersections(const PatientProfiles& profiles, const std::vector<int>& intersections,
+                                                SimilarityMetric metric) {
+    const size_t n = profiles.patients.size();
+    std::vector<double> matrix(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            matrix[i * n + j] = similarity(intersections[i * n + j], profiles.cardinality[i], profiles.cardinality[j], metric);
+    return matrix;
+}
+
+
+std::vector<double> computeSimilarityMatrix(const PatientProfiles& profiles, SimilarityMetric metric, size_t threads) {
+    return similarityFromIntersections(profiles, computeIntersectionMatrix(profiles, threads), metric);
+}
+
+
+void writeSimilarityMatrixCSV(const PatientProfiles& profiles, const std::vector<double>& matrix,
+                              const std::map<int, std::string>& patientToDiseaseMap, const std::string& filename) {
+    const size_t n = profiles.patients.size();
+    CsvWriter csv(filename);
+    csv.field("Patient").field("Disease");
+    for (int patientID : profiles.patients) csv.field(patientID);
+    csv.endRow();
+
+    for (size_t i = 0; i < n; ++i) {
+        auto it = patientToDiseaseMap.find(profiles.patients[i]);
+        csv.field(profiles.patients[i]).field(it != patientToDiseaseMap.end() ? it->second : "Unknown");
+        for (size_t j = 0; j < n; ++j) csv.field(matrix[i * n + j]);
+        csv.endRow();
+    }
+    csv.close();
+}
+
+
+void writePatientSimilarity(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                            const std::map<int, std::string>& patientToDiseaseMap, const std::string& outputDir) {
+    for (const std::string category : {"", "donor", "pre", "post"}) {
+        PatientProfiles profiles = buildPatientProfiles(colocalizationByIndividual, category);
+        const std::string suffix = category.empty() ? "all" : category;
+
+        // One popcount pass serves both metrics
+        const std::vector<int> intersections = computeIntersectionMatrix(profiles);
+        writeSimilarityMatrixCSV(profiles, similarityFromIntersections(profiles, intersections, SimilarityMetric::Jaccard),
+                                 patientToDiseaseMap, outputDir + "/jaccard_" + suffix + ".csv");
+        writeSimilarityMatrixCSV(profiles, similarityFromIntersections(profiles, intersections, SimilarityMetric::Cosine),
+                                 patientToDiseaseMap, outputDir + "/cosine_" + suffix + ".csv");
+
+        std::cout << "Patient similarity (" << suffix << "): " << profiles.patients.size()
+                  << " patients x " << profiles.pairs.size() << " pairs\n";
+    }
+}
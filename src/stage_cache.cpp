@@ -0,0 +1,250 @@
+/* Content-addressed stage cache: skips pipeline stages whose inputs, parameters and code are unchanged */
+#include "../include/stage_cache.h"
+#include "../include/console_capture.h"
+#include "../external/json.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#ifndef CONET_CODE_VERSION
+#define CONET_CODE_VERSION "dev"
+#endif
+
+namespace fs = std::filesystem;
+using nlohmann::json;
+
+namespace {
+
+std::string normalPath(const std::string& path) {
+    return fs::path(path).lexically_normal().generic_string();
+}
+
+bool parseHex(const std::string& hex, uint64_t& value) {
+    if (hex.empty() || hex.size() > 16) return false;
+    try {
+        size_t used = 0;
+        value = std::stoull(hex, &used, 16);
+        return used == hex.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::atomic<unsigned> tmpCounter{0};
+
+// Unique per call, so concurrent stages storing the same object never share a temp file
+fs::path tmpPathFor(const fs::path& to) {
+    fs::path tmp = to;
+    tmp += ".tmp" + std::to_string(tmpCounter.fetch_add(1));
+    return tmp;
+}
+
+// Write to a sibling temp file and rename, so an interrupted run never leaves a truncated file behind
+void copyAtomically(const fs::path& from, const fs::path& to) {
+    const fs::path tmp = tmpPathFor(to);
+    fs::copy_file(from, tmp, fs::copy_options::overwrite_existing);
+    fs::rename(tmp, to);
+}
+
+void writeAtomically(const fs::path& to, const std::string& content) {
+    const fs::path tmp = tmpPathFor(to);
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        if (!out) throw std::runtime_error("Cannot write cache file: " + tmp.string());
+        out << content;
+    }
+    fs::rename(tmp, to);
+}
+
+} // namespace
+
+
+uint64_t hashFileContents(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    uint64_t hash = FNV_OFFSET_BASIS;
+    char buffer[1 << 16];
+    while (in) {
+        in.read(buffer, sizeof(buffer));
+        hash = fnv1a64(buffer, static_cast<size_t>(in.gcount()), hash);
+    }
+    return hash;
+}
+
+
+uint64_t codeVersionHash(const char* argv0) {
+    std::error_code ec;
+    fs::path exe = fs::read_symlink("/proc/self/exe", ec);
+    if (ec || !fs::exists(exe, ec)) exe = argv0 ? argv0 : "";
+    const uint64_t exeHash = hashFileContents(exe.string());
+    return fnv1a64(&exeHash, sizeof(exeHash), fnv1a64(std::string(CONET_CODE_VERSION)));
+}
+
+
+std::string hexDigest(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) hex[i] = digits[hash & 0xF];
+    return hex;
+}
+
+
+StageCache::StageCache(std::string dir, uint64_t baseKey, bool enabled)
+    : dir_(std::move(dir)), baseKey_(baseKey), enabled_(enabled)
+{
+    if (enabled_) {
+        fs::create_directories(dir_ / "objects");
+        fs::create_directories(dir_ / "stages");
+    }
+}
+
+
+std::string StageCache::keyOf(const StageSpec& spec) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& output : spec.outputs) declaredBy_.emplace(normalPath(output), spec.name);
+    }
+    uint64_t hash = fnv1a64(spec.name, baseKey_);
+    for (const auto& p : spec.params) hash = fnv1a64(p, hash);
+    for (const auto& o : spec.outputs) hash = fnv1a64(o, hash);
+    return hexDigest(hash);
+}
+
+
+bool StageCache::upToDate(const StageSpec& spec) {
+    return enabled_ && restore(spec, keyOf(spec), false);
+}
+
+
+bool StageCache::run(const StageSpec& spec, const std::function<void()>& stage) {
+    if (!enabled_) {
+        stage();
+        return true;
+    }
+
+    const std::string key = keyOf(spec);
+    if (restore(spec, key, true)) {
+        ++hits_;
+        std::cerr << "[cache] " << spec.name << " up to date\n";
+        return false;
+    }
+
+    const Snapshot before = snapshot(spec);
+    std::string console;
+    {
+        ConsoleCapture capture(true);
+        stage();
+        console = capture.text();
+    }
+    const Snapshot after = snapshot(spec);
+
+    // Outputs = files the stage created or rewrote
+    std::vector<std::string> outputs;
+    for (const auto& [path, stamp] : after) {
+        auto it = before.find(path);
+        if (it == before.end() || it->second != stamp) outputs.push_back(path);
+    }
+    record(spec, key, outputs, console);
+    ++misses_;
+    return true;
+}
+
+
+StageCache::Snapshot StageCache::snapshot(const StageSpec& spec) const {
+    Snapshot files;
+    std::error_code ec;
+    auto add = [&](const fs::path& file) {
+        const std::string path = file.lexically_normal().generic_string();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto owner = declaredBy_.find(path);
+            if (owner != declaredBy_.end() && owner->second != spec.name) return;
+        }
+        files[path] = {fs::last_write_time(file, ec), fs::file_size(file, ec)};
+    };
+
+    for (const auto& output : spec.outputs) {
+        const fs::path out(output);
+        if (fs::is_directory(out, ec)) {
+            for (auto it = fs::recursive_directory_iterator(out, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+                if (it->is_regular_file(ec)) add(it->path());
+        } else {
+            // A file, or a prefix such as <dir>/centrality matching <dir>/centrality_*.csv
+            const std::string prefix = normalPath(output);
+            const fs::path parent = out.has_parent_path() ? out.parent_path() : fs::path(".");
+            if (!fs::is_directory(parent, ec)) continue;
+            for (const auto& entry : fs::directory_iterator(parent, ec)) {
+                if (!entry.is_regular_file(ec)) continue;
+                if (entry.path().lexically_normal().generic_string().compare(0, prefix.size(), prefix) == 0) add(entry.path());
+            }
+        }
+    }
+    return files;
+}
+
+
+void StageCache::storeObject(uint64_t hash, const fs::path& source) const {
+    const fs::path object = dir_ / "objects" / hexDigest(hash);
+    if (!fs::exists(object)) copyAtomically(source, object);
+}
+
+
+void StageCache::record(const StageSpec& spec, const std::string& key, const std::vector<std::string>& outputs,
+                        const std::string& console) const
+{
+    json files = json::object();
+    for (const auto& path : outputs) {
+        const uint64_t hash = hashFileContents(path);
+        storeObject(hash, path);
+        files[path] = hexDigest(hash);
+    }
+
+    const uint64_t consoleHash = fnv1a64(console);
+    const fs::path consoleObject = dir_ / "objects" / hexDigest(consoleHash);
+    if (!fs::exists(consoleObject)) writeAtomically(consoleObject, console);
+
+    json manifest = {{"stage", spec.name}, {"key", key}, {"stdout", hexDigest(consoleHash)}, {"outputs", files}};
+    writeAtomically(dir_ / "stages" / (spec.name + ".json"), manifest.dump(2));
+}
+
+
+// apply = false only checks that the stage could be skipped
+bool StageCache::restore(const StageSpec& spec, const std::string& key, bool apply) const {
+    std::ifstream in(dir_ / "stages" / (spec.name + ".json"));
+    if (!in) return false;
+
+    json manifest;
+    try {
+        in >> manifest;
+        if (manifest.at("key").get<std::string>() != key) return false;
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    // Check everything first so a partial restore never mixes runs
+    std::vector<std::pair<fs::path, fs::path>> copies;
+    const json outputs = manifest.value("outputs", json::object());
+    for (const auto& [path, hex] : outputs.items()) {
+        uint64_t expected;
+        if (!hex.is_string() || !parseHex(hex.get<std::string>(), expected)) return false;
+        if (fs::exists(path) && hashFileContents(path) == expected) continue;
+
+        const fs::path object = dir_ / "objects" / hex.get<std::string>();
+        if (!fs::exists(object) || hashFileContents(object.string()) != expected) return false;
+        copies.emplace_back(object, path);
+    }
+    std::ifstream consoleFile(dir_ / "objects" / manifest.value("stdout", std::string()), std::ios::binary);
+    if (!consoleFile) return false;
+    if (!apply) return true;
+
+    std::ostringstream console;
+    console << consoleFile.rdbuf();
+    for (const auto& [object, path] : copies) {
+        if (path.has_parent_path()) fs::create_directories(path.parent_path());
+        copyAtomically(object, path);
+        std::cerr << "[cache] restored " << path.generic_string() << "\n";
+    }
+    std::cout << console.str();
+    return true;
+}
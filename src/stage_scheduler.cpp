@@ -0,0 +1,122 @@
+/* DAG scheduler for the pipeline stages in main */
+#include "../include/stage_scheduler.h"
+#include "../include/console_capture.h"
+#include "../include/parallel.h"
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+StageScheduler::StageScheduler(size_t threads) : threads_(threads ? threads : defaultThreadCount()) {}
+
+
+void StageScheduler::add(std::string name, std::vector<std::string> after, std::function<void()> run) {
+    for (const auto& stage : stages_)
+        if (stage.name == name) throw std::invalid_argument("Duplicate stage: " + name);
+    Stage stage;
+    stage.name = std::move(name);
+    stage.after = std::move(after);
+    stage.run = std::move(run);
+    stages_.push_back(std::move(stage));
+}
+
+
+void StageScheduler::run() {
+    const size_t n = stages_.size();
+    std::unordered_map<std::string, size_t> indexOf;
+    for (size_t i = 0; i < n; ++i) indexOf[stages_[i].name] = i;
+
+    for (size_t i = 0; i < n; ++i) {
+        stages_[i].pending = stages_[i].after.size();
+        stages_[i].done = false;
+        stages_[i].dependents.clear();
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (const auto& dep : stages_[i].after) {
+            auto it = indexOf.find(dep);
+            if (it == indexOf.end()) throw std::invalid_argument("Stage " + stages_[i].name + " depends on unknown stage " + dep);
+            stages_[it->second].dependents.push_back(i);
+        }
+    }
+
+    // Kahn's algorithm up front, so a cycle is reported before anything runs
+    {
+        std::vector<size_t> pending(n);
+        std::vector<size_t> queue;
+        for (size_t i = 0; i < n; ++i) if ((pending[i] = stages_[i].pending) == 0) queue.push_back(i);
+        for (size_t q = 0; q < queue.size(); ++q)
+            for (size_t d : stages_[queue[q]].dependents)
+                if (--pending[d] == 0) queue.push_back(d);
+        if (queue.size() != n) throw std::invalid_argument("Stage dependencies contain a cycle");
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::set<size_t> ready;            // lowest index first: follows the order stages were added
+    for (size_t i = 0; i < n; ++i) if (stages_[i].pending == 0) ready.insert(i);
+    size_t running = 0, printed = 0;
+    std::exception_ptr failure;
+
+    // Hand finished consoles to the terminal in stage order (called with the lock held)
+    auto release = [&]() {
+        for (; printed < n && stages_[printed].done; ++printed) {
+            std::cout << stages_[printed].console;
+            stages_[printed].console.clear();
+        }
+        std::cout.flush();
+    };
+
+    // Runs stage i on a pool thread; the stage's own parallel loops queue their helpers on the same pool
+    auto execute = [&](size_t i) {
+        std::string console;
+        std::exception_ptr error;
+        {
+            ConsoleCapture capture;
+            try {
+                stages_[i].run();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            console = capture.text();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        stages_[i].console = std::move(console);
+        stages_[i].done = true;
+        if (error && !failure) failure = error;
+        if (failure) ready.clear();
+        else {
+            for (size_t d : stages_[i].dependents)
+                if (--stages_[d].pending == 0) ready.insert(d);
+        }
+        release();
+        wake.notify_all();
+    };
+
+    // The calling thread only dispatches: at most threads_ stages are in the pool at once
+    ConsoleCapture::install();
+    ThreadPool& pool = sharedPool();
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&]() { return (!ready.empty() && running < threads_) || running == 0; });
+        if (ready.empty() && running == 0) break;
+        while (!ready.empty() && running < threads_) {
+            const size_t i = *ready.begin();
+            ready.erase(ready.begin());
+            ++running;
+            pool.submit([&execute, i]() { execute(i); });
+        }
+    }
+    lock.unlock();
+
+    if (failure) {
+        // Stages after the failed one never ran; still show what the finished ones printed
+        for (size_t i = printed; i < n; ++i) if (stages_[i].done) std::cout << stages_[i].console;
+        std::cout.flush();
+        std::rethrow_exception(failure);
+    }
+}
@@ -0,0 +1,187 @@
+/* Kaplan–Meier persistence / emergence curves over per-patient timeline masks */
+#include "../include/survival.h"
+#include "../include/analysis.h"
+#include "../include/bits.h"
+#include "../include/csv_writer.h"
+#include "../include/id_maps.h"
+#include "../include/parallel.h"
+#include "../external/json.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using ColocIter = std::map<std::tuple<int, int, int>, std::set<Timepoint>>::const_iterator;
+
+enum Analysis { Disappearance = 0, Emergence = 1 };
+
+struct Subject {
+    int mge;
+    int analysis;
+    int day;
+    bool event;
+};
+
+// Subjects of one patient; [begin, end) holds all of the patient's (ARG, MGE) entries
+void patientSubjects(ColocIter begin, ColocIter end, std::vector<Subject>& out) {
+    // Patient's chronological chain of non-donor samples; bit k = k-th sample
+    std::vector<int> sampled;
+    for (auto it = begin; it != end; ++it)
+        for (const Timepoint& tp : it->second)
+            if (tp != Timepoint::Donor) sampled.push_back(static_cast<int>(tp));
+    std::sort(sampled.begin(), sampled.end());
+    sampled.erase(std::unique(sampled.begin(), sampled.end()), sampled.end());
+    if (sampled.size() > 64) sampled.resize(64);
+
+    if (sampled.size() < 2 || sampled.front() != static_cast<int>(Timepoint::PreFMT)) return;
+
+    const uint64_t preBit = 1;
+    const uint64_t validBits = sampled.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << sampled.size()) - 1;
+    const uint64_t postBits = validBits & ~preBit;
+    const int lastDay = sampled.back();
+
+    for (auto it = begin; it != end; ++it) {
+        uint64_t mask = 0;
+        bool donor = false;
+        for (const Timepoint& tp : it->second) {
+            if (tp == Timepoint::Donor) { donor = true; continue; }
+            auto pos = std::lower_bound(sampled.begin(), sampled.end(), static_cast<int>(tp));
+            if (pos != sampled.end() && *pos == static_cast<int>(tp))
+                mask |= uint64_t(1) << (pos - sampled.begin());
+        }
+        const int mge = std::get<2>(it->first);
+
+        if (mask & preBit) {
+            const uint64_t absentPost = ~mask & postBits;
+            if (absentPost) out.push_back({mge, Disappearance, sampled[countTrailingZeros(absentPost)], true});
+            else            out.push_back({mge, Disappearance, lastDay, false});
+        } else if (donor || (mask & postBits)) {
+            const uint64_t presentPost = mask & postBits;
+            if (presentPost) out.push_back({mge, Emergence, sampled[countTrailingZeros(presentPost)], true});
+            else             out.push_back({mge, Emergence, lastDay, false});
+        }
+    }
+}
+
+// Product-limit estimate from (day, event) observations
+std::vector<KMPoint> kaplanMeier(std::vector<std::pair<int, bool>>& observations) {
+    std::sort(observations.begin(), observations.end());
+    std::vector<KMPoint> curve;
+    int atRisk = static_cast<int>(observations.size());
+    double survival = 1.0;
+    curve.push_back({0, atRisk, 0, 0, survival});
+
+    size_t i = 0;
+    while (i < observations.size()) {
+        const int day = observations[i].first;
+        int events = 0, censored = 0;
+        for (; i < observations.size() && observations[i].first == day; ++i)
+            observations[i].second ? ++events : ++censored;
+        if (events) survival *= 1.0 - static_cast<double>(events) / atRisk;
+        curve.push_back({day, atRisk, events, censored, survival});
+        atRisk -= events + censored;
+    }
+    return curve;
+}
+
+} // namespace
+
+
+KMCurves computeKaplanMeierCurves(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                                  const std::map<int, std::string>& patientToDiseaseMap, size_t threads) {
+    // The map is ordered by patient first, so each patient is one contiguous range
+    std::vector<std::pair<ColocIter, ColocIter>> patients;
+    std::vector<int> patientIDs;
+    for (auto it = colocalizationByIndividual.begin(); it != colocalizationByIndividual.end();) {
+        const int patientID = std::get<0>(it->first);
+        auto next = it;
+        while (next != colocalizationByIndividual.end() && std::get<0>(next->first) == patientID) ++next;
+        patients.emplace_back(it, next);
+        patientIDs.push_back(patientID);
+        it = next;
+    }
+
+    const size_t workers = workerCount(patients.size(), threads);
+    std::vector<std::vector<std::pair<size_t, Subject>>> perThread(workers);
+    parallelForChunks(patients.size(), [&](size_t begin, size_t end, size_t t) {
+        std::vector<Subject> subjects;
+        for (size_t p = begin; p < end; ++p) {
+            subjects.clear();
+            patientSubjects(patients[p].first, patients[p].second, subjects);
+            for (const auto& s : subjects) perThread[t].emplace_back(p, s);
+        }
+    }, workers);
+
+    // Group observations: analysis -> group type -> group -> (day, event)
+    const char* analysisName[] = {"disappearance", "emergence"};
+    std::map<std::string, std::map<std::string, std::map<std::string, std::vector<std::pair<int, bool>>>>> observations;
+    std::unordered_map<int, std::string> mgeGroupCache;
+
+    for (const auto& part : perThread) {
+        for (const auto& [p, s] : part) {
+            auto disease = patientToDiseaseMap.find(patientIDs[p]);
+            auto group = mgeGroupCache.find(s.mge);
+            if (group == mgeGroupCache.end()) group = mgeGroupCache.emplace(s.mge, getMGEGroupName(s.mge)).first;
+
+            auto& byType = observations[analysisName[s.analysis]];
+            byType["All"]["All"].emplace_back(s.day, s.event);
+            byType["Disease"][disease != patientToDiseaseMap.end() ? disease->second : "Unknown"].emplace_back(s.day, s.event);
+            byType["MGEGroup"][group->second].emplace_back(s.day, s.event);
+        }
+    }
+
+    KMCurves curves;
+    for (auto& [analysis, byType] : observations)
+        for (auto& [groupType, byGroup] : byType)
+            for (auto& [group, obs] : byGroup)
+                curves[analysis][groupType][group] = kaplanMeier(obs);
+
+    for (const auto& [analysis, byType] : curves) {
+        const auto& all = byType.at("All").at("All");
+        std::cout << "Kaplan-Meier (" << analysis << "): " << all.front().atRisk
+                  << " subjects, S(end)=" << all.back().survival << "\n";
+    }
+    return curves;
+}
+
+
+void writeKaplanMeierCSV(const KMCurves& curves, const std::string& filename) {
+    CsvWriter csv(filename);
+    csv.header({"Analysis","GroupType","Group","Day","AtRisk","Events","Censored","Survival"});
+    for (const auto& [analysis, byType] : curves)
+        for (const auto& [groupType, byGroup] : byType)
+            for (const auto& [group, curve] : byGroup)
+                for (const auto& pt : curve)
+                    csv.row(analysis, groupType, group, pt.day, pt.atRisk, pt.events, pt.censored, pt.survival);
+    csv.close();
+}
+
+
+void writeKaplanMeierJSON(const KMCurves& curves, const std::string& filename) {
+    nlohmann::json root = nlohmann::json::object();
+    for (const auto& [analysis, byType] : curves)
+        for (const auto& [groupType, byGroup] : byType)
+            for (const auto& [group, curve] : byGroup) {
+                nlohmann::json points = nlohmann::json::array();
+                for (const auto& pt : curve)
+                    points.push_back({
+                        {"day", pt.day},
+                        {"atRisk", pt.atRisk},
+                        {"events", pt.events},
+                        {"censored", pt.censored},
+                        {"survival", pt.survival}
+                    });
+                root[analysis][groupType][group] = points;
+            }
+
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open output JSON file: " + filename);
+    }
+    out << root.dump(2) << '\n';
+}
@@ -0,0 +1,113 @@
+/* Single-pass donor/pre/post classification of patientwise colocalizations */
+#include "../include/temporal_classifier.h"
+#include "../include/analysis.h"
+#include "../include/csv_writer.h"
+#include "../include/json_writer.h"
+#include "../include/id_maps.h"
+#include <iostream>
+#include <stdexcept>
+
+unsigned temporalPattern(const std::set<Timepoint>& tps) {
+    unsigned pattern = 0;
+    for (const Timepoint& tp : tps) {
+        switch (traitsOf(tp).category) {
+            case TimepointCategory::Donor:   pattern |= InDonor; break;
+            case TimepointCategory::PreFMT:  pattern |= InPreFMT; break;
+            case TimepointCategory::PostFMT: pattern |= InPostFMT; break;
+            case TimepointCategory::Unknown: break;
+        }
+        if (pattern == (InDonor | InPreFMT | InPostFMT)) break;
+    }
+    return pattern;
+}
+
+
+PatternCountSink::PatternCountSink(std::vector<PatternLabel> patterns)
+    : patterns_(std::move(patterns)), counts_(patterns_.size(), 0) {}
+
+void PatternCountSink::consume(int, int, int, unsigned pattern) {
+    for (size_t i = 0; i < patterns_.size(); ++i)
+        if (patterns_[i].pattern == pattern) counts_[i]++;
+}
+
+void PatternCountSink::finish() {
+    for (size_t i = 0; i < patterns_.size(); ++i)
+        std::cout << "Colocalizations (" << patterns_[i].label << "): " << counts_[i] << "\n";
+}
+
+
+PatternCSVSink::PatternCSVSink(std::string filename, std::vector<PatternLabel> patterns)
+    : filename_(std::move(filename)), patterns_(std::move(patterns)), patientCounts_(patterns_.size()) {}
+
+void PatternCSVSink::consume(int, int argID, int mgeID, unsigned pattern) {
+    // Keys are unique per patient, so counting entries counts patients
+    for (size_t i = 0; i < patterns_.size(); ++i)
+        if (patterns_[i].pattern == pattern) patientCounts_[i][{argID, mgeID}]++;
+}
+
+void PatternCSVSink::finish() {
+    for (size_t i = 0; i < patterns_.size(); ++i) {
+        CsvWriter csv(filename_, patterns_[i].append);
+        csv.header({"ARG_Name","MGE_Name","PatientCount","Label"});
+        for (const auto& [pair, patients] : patientCounts_[i])
+            csv.row(getARGName(pair.first), getMGEName(pair.second), patients, patterns_[i].label);
+        csv.close();
+    }
+}
+
+
+DiseaseStatusJSONSink::DiseaseStatusJSONSink(const std::map<int, std::string>& patientToDiseaseMap, std::string jsonOutputPath, bool compact)
+    : patientToDiseaseMap_(patientToDiseaseMap), jsonOutputPath_(std::move(jsonOutputPath)), compact_(compact) {}
+
+void DiseaseStatusJSONSink::consume(int patientID, int argID, int mgeID, unsigned pattern) {
+    const bool donor = pattern & InDonor, pre = pattern & InPreFMT, post = pattern & InPostFMT;
+
+    const char* status;
+    if (post && !pre && !donor) status = "emerged";
+    else if (pre && !post && !donor) status = "disappeared";
+    else if (donor && post && !pre) status = "transferred";
+    else if (pre && post) status = "persisted";
+    else return; // skip other patterns
+
+    counts_[patientToDiseaseMap_.at(patientID)][{argID, mgeID}][status]++;
+}
+
+void DiseaseStatusJSONSink::finish() {
+    JsonWriter out(jsonOutputPath_, compact_ ? -1 : 2);
+    out.beginObject();
+
+    for (const auto& [disease, pairMap] : counts_) {
+        // Names are resolved once per pair; pairs sharing a display name are merged as before
+        std::map<std::string, std::map<std::string, int>> colocMap;
+        for (const auto& [pair, statusMap] : pairMap) {
+            auto& named = colocMap[getARGName(pair.first) + "–" + getMGEName(pair.second)];
+            for (const auto& [status, count] : statusMap) named[status] += count;
+        }
+
+        out.key(disease).beginArray();
+        for (const auto& [pairName, statusMap] : colocMap) {
+            for (const auto& [status, count] : statusMap) {
+                out.beginObject()
+                   .field("colocalization", pairName)
+                   .field("patients", count)
+                   .field("status", status)
+                   .endObject();
+            }
+        }
+        out.endArray();
+    }
+
+    out.endObject();
+    out.close();
+}
+
+
+void classifyTemporalDynamics(const std::map<std::tuple<int, int, int>, std::set<Timepoint>>& colocalizationByIndividual,
+                              const std::vector<TemporalDynamicsSink*>& sinks) {
+    for (const auto& [tuple, tps] : colocalizationByIndividual) {
+        const auto& [patientID, argID, mgeID] = tuple;
+        const unsigned pattern = temporalPattern(tps);
+        for (TemporalDynamicsSink* sink : sinks) sink->consume(patientID, argID, mgeID, pattern);
+    }
+    for (TemporalDynamicsSink* sink : sinks) sink->finish();
+}
@@ -3,6 +3,7 @@
 #include "../include/graph.h"
 #include "../include/Timepoint.h"
 #include "../include/id_maps.h"
+#include "../include/topk.h"
 #include <map>
 #include <tuple>
 #include <set>
@@ -221,29 +222,19 @@ void traverseGraphByInd(const Graph& graph, std::unordered_map<Node, std::unorde
 /************************************************   **********************************************/
 // This function retrieves the top K entities (ARGs or MGEs) based on their frequency of occurrence in the graph
 std::vector<std::pair<int, int>> getTopKEntities(const Graph& graph, bool isARG, unsigned int K) {
-    std::unordered_map<int, int> countMap;
+    TopKCounter<int> counter;
 
     for (const Edge& edge : graph.edges) {
         if (!edge.isColo) continue;
         const Node& node = isARG ? edge.source : edge.target;
  
         if (node.isARG == isARG && node.timepoint != Timepoint::Donor) {
-            for (size_t i = 0; i < edge.individuals.size(); ++i) {
-                // Count occurrences of ARG or MGE by individual
-                countMap[node.id]++;
-            }
+            // Count occurrences of ARG or MGE by individual
+            counter.add(node.id, static_cast<int>(edge.individuals.size()));
         }
     }
 
-    std::vector<std::pair<int, int>> freqList(countMap.begin(), countMap.end());
-    std::sort(freqList.begin(), freqList.end(), [](auto& a, auto& b) {
-        return a.second > b.second;
-    });
-
-    if (K < freqList.size())
-        freqList.resize(K);
-    
-    return freqList;
+    return counter.top(K);
 }
 
 // Retrieve the timeline of a specific ARG and all MGEs it colocalizes with over time
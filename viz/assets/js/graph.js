@@ -9,6 +9,16 @@ svg.call(d3.zoom().scaleExtent([0.2, 8])
 let originalData = {}; 
 let currentGraphKey = "json/graph1.json"; 
 
+// Resident server (CoNet --serve): open the tool with ?server=http://127.0.0.1:8080 and the
+// interaction view fetches only the disease/timepoint slice it renders instead of graph1.json
+const conetServer = new URLSearchParams(window.location.search).get("server");
+
+// Colocalization view shards (CoNet viz.parent_shards_dir) fetched per filter; graph2.json is the fallback
+const PARENT_SHARDS = "json/shards/graph2/";
+let parentShardManifest;   // undefined until fetched, null when no shards were exported
+
+const communityColor = d3.scaleOrdinal(d3.schemeTableau10);
+
 const shapeMap = { circle: d3.symbolCircle, box: d3.symbolCircle, triangle: d3.symbolTriangle, diamond: d3.symbolDiamond, hexagon: d3.symbolCross, octagon: d3.symbolStar, parallelogram: d3.symbolWye, trapezium: d3.symbolSquare,  };
 
 // --- DATA LOADING & INITIALIZATION ---
@@ -23,11 +33,21 @@ function loadAndRenderGraph(fileKey) {
     } else {
         enableAllFilters();
     }
+    // The server slices graph1 only; the group rollup view is always loaded from its file
+    if (conetServer && fileKey.endsWith("graph1.json")) {
+        applyFiltersAndDraw();
+        return;
+    }
+    if (isColoView && parentShardManifest !== null) {
+        loadParentShardManifest();
+        return;
+    }
     if (originalData[fileKey]) {
         populateFilters(originalData[fileKey]);
         applyFiltersAndDraw();
     } else {
-        d3.json(fileKey).then(data => {
+        d3.json(fileKey).then(raw => {
+            const data = expandGraphJson(raw);
             originalData[fileKey] = data;
             populateFilters(data);
             applyFiltersAndDraw();
@@ -35,16 +55,67 @@ function loadAndRenderGraph(fileKey) {
     }
 }
 
+// --- COLUMNAR SCHEMA ---
+// graph1/graph2 written with "graph_schema": "columnar" (see include/export_graph_json.h) hold one
+// array per field plus lookup tables; expand them into the {nodes, links} records the views use
+const CODED_COLUMNS = ["color", "shape", "mgeGroup", "timepointCategory", "style", "type"];
+const FLAG_COLUMNS = ["isARG", "isColo"];
+
+function expandGraphJson(data) {
+    if (!data || data.format !== "conet-columnar-1") return data;
+    const tables = data.tables;
+
+    const expandRows = (columns, rowCount) => {
+        const rows = Array.from({ length: rowCount }, () => ({}));
+        Object.entries(columns).forEach(([name, values]) => {
+            if (CODED_COLUMNS.includes(name)) {
+                const table = tables[name];
+                values.forEach((v, i) => { rows[i][name] = table[v]; });
+            } else if (FLAG_COLUMNS.includes(name)) {
+                values.forEach((v, i) => { rows[i][name] = v === 1; });
+            } else if (name === "diseases") {
+                values.forEach((v, i) => { rows[i].diseases = v.map(d => tables.disease[d]); });
+            } else if (name === "diseaseCounts") {
+                values.forEach((pairs, i) => {
+                    const counts = {};
+                    for (let k = 0; k < pairs.length; k += 2) counts[tables.disease[pairs[k]]] = pairs[k + 1];
+                    rows[i].diseaseCounts = counts;
+                    rows[i].diseases = Object.keys(counts);
+                });
+            } else if (name === "community") {
+                values.forEach((v, i) => { if (v >= 0) rows[i].community = v; });
+            } else {
+                values.forEach((v, i) => { rows[i][name] = v; });
+            }
+        });
+        return rows;
+    };
+
+    const nodes = expandRows(data.nodes, data.nodes.id.length);
+    const links = expandRows(data.links, data.links.source.length);
+    // Shards keep ids for endpoints stored in another shard
+    links.forEach(l => {
+        if (typeof l.source === "number") l.source = nodes[l.source].id;
+        if (typeof l.target === "number") l.target = nodes[l.target].id;
+    });
+    return { nodes, links, timepointCategories: data.timepointCategories };
+}
+
 // --- POPULATE FILTER DROPDOWNS ---
 function populateFilters(data) {
+    setTimepointCategories(data.timepointCategories);
+    const nodeSource = currentGraphKey.includes("graph1")
+        ? data.nodes.filter(n => !n.isARG)
+        : data.nodes;
+    populateGroupMenu(nodeSource.map(n => n.mgeGroup));
+}
+
+function populateGroupMenu(groupNames) {
     const menu = document.querySelector("#mgeGroupMenu");
     menu.innerHTML = `
         <li><a class="dropdown-item active" data-value="all">All Groups</a></li>
     `;
-    const nodeSource = currentGraphKey.includes("graph1")
-        ? data.nodes.filter(n => !n.isARG)
-        : data.nodes;
-    const groups = [...new Set(nodeSource.map(n => n.mgeGroup).filter(Boolean))].sort();
+    const groups = [...new Set(groupNames.filter(Boolean))].sort();
     groups.forEach(g => {
         menu.innerHTML += `<li><a class="dropdown-item" data-value="${g}">${g}</a></li>`;
     });
@@ -116,11 +187,104 @@ function resetSingleDropdown(hiddenSelector, labelText) {
 }
 
 
+// --- COLOCALIZATION VIEW SHARDS ---
+function loadParentShardManifest() {
+    if (parentShardManifest) {
+        populateGroupMenu(Object.keys(parentShardManifest.mgeGroups));
+        applyFiltersAndDraw();
+        return;
+    }
+    d3.json(`${PARENT_SHARDS}manifest.json`).then(manifest => {
+        parentShardManifest = manifest;
+        setTimepointCategories(manifest.timepointCategories);
+    }).catch(() => {
+        parentShardManifest = null;
+    }).then(() => {
+        if (currentGraphKey.endsWith("graph2.json")) loadAndRenderGraph(currentGraphKey);
+    });
+}
+
+// Union of the shards the current disease/timepoint/MGE group filter needs; null while they load.
+// An MGE group shard spans all diseases and timepoints, the regular filters narrow it down.
+function currentShardData() {
+    const manifest = parentShardManifest;
+    const group = d3.select("#mgeGroupFilter").property("value");
+    const disease = d3.select("#diseaseFilter").property("value");
+
+    let files;
+    if (group !== "all") {
+        files = manifest.mgeGroups[group] ? [manifest.mgeGroups[group]] : [];
+    } else {
+        const byCategory = disease === "all" ? manifest.all : (manifest.diseases[disease] || {});
+        files = d3.selectAll(".timepoint-checkbox").nodes()
+            .filter(cb => cb.checked)
+            .map(cb => byCategory[cb.value])
+            .filter(Boolean);
+    }
+    const key = `shards:${files.join("|")}`;
+    if (originalData[key]) return originalData[key];
+
+    const missing = files.filter(f => !originalData[`shard:${f}`]);
+    if (missing.length) {
+        const url = f => PARENT_SHARDS + f.split("/").map(encodeURIComponent).join("/");
+        Promise.all(missing.map(f => d3.json(url(f)).then(raw => {
+            originalData[`shard:${f}`] = expandGraphJson(raw);
+        }))).then(applyFiltersAndDraw)
+            .catch(error => console.error("Error loading shards:", error));
+        return null;
+    }
+
+    // Every node and link is in exactly one of the shards a filter selects
+    const merged = { nodes: [], links: [] };
+    files.forEach(f => {
+        const shard = originalData[`shard:${f}`];
+        merged.nodes.push(...shard.nodes);
+        merged.links.push(...shard.links);
+    });
+    originalData[key] = merged;
+    return merged;
+}
+
+
+// --- SERVER SLICES ---
+// Data the filters run on: the loaded file, or in server mode the slice for the current disease/timepoints
+function currentSourceData() {
+    if (currentGraphKey.includes("graph2") && parentShardManifest) return currentShardData();
+    if (!conetServer || !currentGraphKey.endsWith("graph1.json")) return originalData[currentGraphKey];
+
+    const q = serverSliceQuery();
+    if (q === null) return { nodes: [], links: [] };
+    const key = `server:${q}`;
+    if (originalData[key]) return originalData[key];
+
+    d3.json(`${conetServer}/subgraph?induced=1&q=${encodeURIComponent(q)}`).then(data => {
+        originalData[key] = data;
+        if (q === "") populateFilters(data);
+        applyFiltersAndDraw();
+    }).catch(error => console.error("Error loading slice from server:", error));
+    return null;
+}
+
+// Predicates for the server's query engine; null when no timepoint is selected
+function serverSliceQuery() {
+    const predicates = [];
+    const disease = d3.select("#diseaseFilter").property("value");
+    if (disease !== "all") predicates.push(`disease = "${disease}"`);
+
+    const boxes = d3.selectAll(".timepoint-checkbox").nodes();
+    const checked = boxes.filter(cb => cb.checked).map(cb => cb.value);
+    if (!checked.length) return null;
+    if (checked.length < boxes.length) predicates.push(`timepoint in (${checked.join(", ")})`);
+    return predicates.join(" and ");
+}
+
+
 // --- CORE FILTERING LOGIC ---
 function applyFiltersAndDraw() {
-    if (!originalData[currentGraphKey]) return;
+    const source = currentSourceData();
+    if (!source) return;
 
-    let data = JSON.parse(JSON.stringify(originalData[currentGraphKey])); 
+    let data = JSON.parse(JSON.stringify(source)); 
 
     const filters = {
         disease: d3.select("#diseaseFilter").property("value"),
@@ -400,7 +564,7 @@ function updateVisualization(data) {
                 return scale(Math.max(MIN_COUNT, Math.min(MAX_COUNT, count)));
             })
         )
-        .attr("fill", d => d.color)
+        .attr("fill", d => nodeFill(d))
         .attr("stroke", "grey")
         .attr("stroke-width", 1.5)
         .call(d3.drag().on("start", dragstart).on("drag", dragged).on("end", dragend));
@@ -423,6 +587,8 @@ function updateVisualization(data) {
     g.selectAll("text.label").style("display", d3.select("#toggleLabels").property("checked") ? "block" : "none");
 
     // --- simulation ---
+    // Positions precomputed by CoNet's layout stage are drawn as they are; the simulation only runs for drags
+    const precomputed = simNodes.every(n => Number.isFinite(n.x) && Number.isFinite(n.y));
     const sim = d3.forceSimulation(simNodes)
         .force("link", d3.forceLink(simLinks).id(d => d.id).distance(d => d.isColo ? 40 : 60))
         .force("charge", d3.forceManyBody().strength(d => -(40 + (d.degree || 0) * 15)))
@@ -431,6 +597,10 @@ function updateVisualization(data) {
         .force("x", d3.forceX(500).strength(0.05))
         .force("y", d3.forceY(350).strength(0.05))
         .on("tick", ticked);
+    if (precomputed) {
+        sim.stop();
+        ticked();
+    }
 
     function ticked() {
         linkSelection.attr("d", d => linkArc(d));
@@ -438,15 +608,29 @@ function updateVisualization(data) {
         labelSelection.attr("x", d => d.x).attr("y", d => d.y);
     }
 
-    function dragstart(event, d) { if (!event.active) sim.alphaTarget(0.3).restart(); d.fx = d.x; d.fy = d.y; }
-    function dragged(event, d) { d.fx = event.x; d.fy = event.y; }
-    function dragend(event, d) { if (!event.active) sim.alphaTarget(0); d.fx = null; d.fy = null; }
+    function dragstart(event, d) { if (!event.active && !precomputed) sim.alphaTarget(0.3).restart(); d.fx = d.x; d.fy = d.y; }
+    function dragged(event, d) {
+        d.fx = event.x; d.fy = event.y;
+        if (precomputed) { d.x = event.x; d.y = event.y; ticked(); }
+    }
+    function dragend(event, d) { if (!event.active && !precomputed) sim.alphaTarget(0); d.fx = null; d.fy = null; }
 
     updateLinkVisibility();
 }
 
 
 
+// Timepoint color by default; community module color when toggled and available (graph1)
+function nodeFill(d) {
+    const byCommunity = d3.select("#toggleCommunity").property("checked");
+    if (byCommunity && d.community !== undefined) return communityColor(d.community);
+    return d.color;
+}
+
+function updateNodeColors() {
+    g.selectAll("path.node").attr("fill", d => nodeFill(d));
+}
+
 function linkArc(d) {
     const r = Math.hypot(d.target.x - d.source.x, d.target.y - d.source.y);
     return `M${d.source.x},${d.source.y}A${r},${r} 0 0,1 ${d.target.x},${d.target.y}`;
@@ -519,16 +703,63 @@ function bindTimepointListeners() {
   });
 }
 
+// Stage categories of the active post-FMT window scheme; the exports list them as timepointCategories
+let timepointCategories = [
+  { name: "donor", label: "Donor", color: "yellow" },
+  { name: "pre", label: "Pre-FMT", color: "red" },
+  { name: "post1", label: "Post-FMT (1–30 d)", color: "#99D2FF" },
+  { name: "post2", label: "Post-FMT (31–60 d)", color: "#4D9DFF" },
+  { name: "post3", label: "Post-FMT (61+ d)", color: "#3A6EFF" }
+];
+
+// Rebuilds the stage checkboxes and the legend when the data uses another scheme; checked states carry over by name
+function setTimepointCategories(categories) {
+  if (!categories || !categories.length) return;
+  if (categories.map(c => c.name).join("|") === timepointCategories.map(c => c.name).join("|")) return;
+  timepointCategories = categories;
+
+  const menu = document.querySelector(".dropdown-menu[aria-labelledby='timepointFilter']");
+  const unchecked = new Set(Array.from(menu.querySelectorAll(".timepoint-checkbox"))
+    .filter(cb => !cb.checked).map(cb => cb.value));
+  menu.innerHTML = "";
+  categories.forEach(c => {
+    const li = document.createElement("li");
+    const label = document.createElement("label");
+    label.className = "dropdown-item";
+    const box = document.createElement("input");
+    box.type = "checkbox";
+    box.className = "me-2 timepoint-checkbox";
+    box.value = c.name;
+    box.checked = !unchecked.has(c.name);
+    label.append(box, ` ${c.label}`);
+    li.appendChild(label);
+    menu.appendChild(li);
+  });
+
+  const legend = document.getElementById("timepointLegend");
+  if (legend) {
+    legend.querySelectorAll("li[data-category]").forEach(li => li.remove());
+    categories.forEach(c => {
+      const li = document.createElement("li");
+      li.dataset.category = c.name;
+      const symbol = document.createElement("span");
+      symbol.className = "legend-symbol";
+      symbol.style.background = c.color;
+      li.append(symbol, ` ${c.name === "donor" ? "Donor Sample" : c.label}`);
+      legend.appendChild(li);
+    });
+  }
+  updateTimepointButtonText();
+}
+
 // Update the button text based on selected timepoints in patient stages filter
 function updateTimepointButtonText() {
-  const checked = Array.from(document.querySelectorAll(".timepoint-checkbox:checked"));
+  const boxes = Array.from(document.querySelectorAll(".timepoint-checkbox"));
+  const checked = boxes.filter(cb => cb.checked);
   const button = document.getElementById("timepointFilter");
   if (!button) return;
 
-  if (checked.length === 5) { button.textContent = "All Stages"; return; }
-  if (checked.length === 0) { button.textContent = "No Stages"; return; }
-
-  if (checked.length === 5) {
+  if (checked.length === boxes.length) {
     button.textContent = "All Stages";
     button.title = "All Stages";
     return;
@@ -539,14 +770,9 @@ function updateTimepointButtonText() {
     return;
   }
 
-  const pretty = {
-    donor: "Donor",
-    pre: "Pre-FMT",
-    post1: "Post-FMT (1–30 d)",
-    post2: "Post-FMT (31–60 d)",
-    post3: "Post-FMT (61+ d)"
-  };
-  button.textContent = checked.map(cb => pretty[cb.value]).join(", ");
+  const pretty = Object.fromEntries(timepointCategories.map(c => [c.name, c.label]));
+  button.textContent = checked.map(cb => pretty[cb.value] || cb.value).join(", ");
+  button.title = button.textContent;
 }
 
 // --- SVG DOWNLOAD ---
@@ -603,7 +829,7 @@ d3.select("#mgeSearch").on("keydown", event => { if (event.key === 'Enter') { ap
 d3.select("#toggleLabels").on("change", () => g.selectAll("text.label").style("display", d3.select("#toggleLabels").property("checked") ? "block" : "none"));
 d3.select("#toggleColo").on("change", updateLinkVisibility);
 d3.select("#toggleTemporal").on("change", updateLinkVisibility);
-d3.selectAll(".timepoint-checkbox").on("change", applyFiltersAndDraw);
+d3.select("#toggleCommunity").on("change", updateNodeColors);
 document.getElementById("downloadSvgBtn").addEventListener("click", downloadCurrentGraphAsSVG);
 
 